@@ -9,6 +9,16 @@
 #include <string>
 #include <chrono>
 #include <deque>
+#include <cmath>
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <atomic>
+#ifdef IM_RICHTEXT_ENABLE_PROFILING
+#include <mutex>
+#include <thread>
+#include <cstdio>
+#endif
 
 #ifdef _WIN32
 #pragma warning( push )
@@ -71,31 +81,105 @@ namespace ImRichText
 
     struct AnimationData
     {
-        std::vector<float> xoffsets;
-        long long lastBlinkTime;
-        long long lastMarqueeTime;
+        std::vector<float> xoffsets; // One per entry in Drawables::MarqueeLines
+        long long lastBlinkTime = 0;
+        long long lastMarqueeTime = 0;
+        long long nextDeadline = -1;
         bool isVisible = true;
+        bool drawn = false;
+
+        // Hit-test results, only updated when mouse (or document) moves
+        ImVec2 lastMouse{ -FLT_MAX, -FLT_MAX };
+        ImVec2 lastHitPos{ -FLT_MAX, -FLT_MAX };
+        int hoveredRegion = -1;
+        std::pair<int, int> hoveredBlock{ -1, -1 };
+        bool linkHovered = false;
+
+        // Damage tracking, only populated if RenderConfig::TrackDamage is set
+        std::vector<BoundedBox> damage; // Changed since previous frame, screen coordinates
+        std::vector<BoundedBox> layoutDamage; // Changed by relayout, document coordinates
+        std::vector<BoundedBox> pendingDamage; // Animation steps visible from next frame
+        std::vector<std::size_t> lineHashes; // Text content of lines in current layout
+        BoundedBox hovered; // Interactive token under mouse in previous frame
+        ImVec2 lastPos{ 0.f, 0.f };
+        ImVec2 lastBounds{ 0.f, 0.f };
+        bool fullDamage = false;
+    };
+
+    // Visitor callbacks of a parsed text, including the words (and line breaks) its content was
+    // segmented into. Unlike the layout, these only depend on the text and few members of the
+    // config (see GetSegmentationKey), hence replaying them lays out the text again without
+    // parsing or segmentation, e.g. when scale or bounds change.
+    struct LayoutTape
+    {
+        enum class EventType
+        {
+            TagStart, Attribute, TagStartDone, Content, TagEnd
+        };
+
+        struct Event
+        {
+            EventType type = EventType::Content;
+            std::string_view text; // Tag, attribute name or content
+            std::optional<std::string_view> value; // Attribute value
+            int firstWord = 0, wordCount = 0; // Segmentation of content
+            bool selfTerminating = false;
+        };
+
+        std::vector<Event> events;
+        std::vector<std::string_view> words; // Line breaks are recorded as empty (null) words
+        std::size_t key = 0;
+        bool complete = false;
+    };
+
+    // Layout shared by rich texts with identical content, config and bounds. It owns a copy of
+    // the text, which the drawables refer to, as it can outlive the texts which created it.
+    struct SharedLayout
+    {
+        std::string source;
+        std::size_t fingerprint = 0;
+        ImVec2 bounds;
+        Drawables drawables;
+        std::size_t hash = 0; // Of the bucket in Context::SharedLayouts
+        std::size_t bytes = 0; // Accounted in LayoutStats once, however many texts share it
     };
 
     struct RichTextData
     {
         ImVec2 specifiedBounds;
         ImVec2 computedBounds;
-        RenderConfig* config = nullptr;
+        RenderConfig* config = nullptr; // Only valid during Render, pushed configs can be released
+        IRenderer* renderer = nullptr; // May cache data for the layout, see EvictLayoutCaches
+        std::size_t fingerprint = 0; // Of the config used for layout
+        std::size_t palette = 0; // Of the config last drawn with
         std::string_view richText;
-        float scale = 1.f;
-        float fontScale = 1.f;
-        uint32_t bgcolor;
+        std::string source; // Copy of the text, if owned
         bool contentChanged = false;
 
         Drawables drawables;
+        std::shared_ptr<SharedLayout> sharedLayout; // Used instead of drawables, if set
+        LayoutTape tape; // Recorded if RenderConfig::CacheSegmentation is set
         AnimationData animationData;
+
+        std::size_t lastShownFrame = 0;
+        std::size_t layoutBytes = 0; // Accounted in LayoutStats
+        bool evicted = false;
+
+#ifdef IM_RICHTEXT_ENABLE_PROFILING
+        ProfileCounters profile;
+#endif
+
+#ifdef IM_RICHTEXT_TARGET_BLEND2D
+        BLImage layer;
+        bool layerValid = false;
+#endif
     };
 
     struct TooltipData
     {
         ImVec2 pos;
         std::string_view content;
+        BoundedBox hovered; // Link or tooltip token under mouse
     };
 
     struct BlockSpanData
@@ -120,6 +204,7 @@ namespace ImRichText
         std::string_view tag;
         TagType tagType = TagType::Unknown;
         int styleIdx = -1;
+        int16_t tagPropIdx = -1;
         bool hasBackground = false;
     };
 
@@ -131,14 +216,347 @@ namespace ImRichText
         bool isMultilineCapable = true;
     };
 
-    static std::unordered_map<std::size_t, RichTextData> RichTextMap;
+    // Slot map of rich text data, handles encode the slot index in the lower half and the slot's 
+    // generation in the upper half, so that handles of removed texts are detected on lookup
+    struct RichTextSlot
+    {
+        RichTextData data;
+        std::size_t generation = 1;
+        bool alive = false;
+    };
+
+    static constexpr std::size_t RichTextSlotBits = sizeof(std::size_t) * 4u;
+    static constexpr std::size_t RichTextSlotMask = (std::size_t{ 1 } << RichTextSlotBits) - 1u;
+
+    // Configs pushed per context. Entries are shared with the handles they were pushed from, and
+    // are only modified (through GetCurrentConfig) once they are no longer shared.
+    using ConfigStack = std::vector<RenderConfigHandle>;
+
+    // Stack of the context last used on the calling thread, which saves a map lookup for every
+    // config access. Stacks are never erased while their owner (identified by Context::Id, as
+    // addresses of destroyed contexts can be reused) is alive, hence the cached pointer is valid.
+    template <typename ContextT>
+    struct ConfigStackCache
+    {
+        std::size_t owner = 0;
+        ContextT* context = nullptr;
+        ConfigStack* stack = nullptr;
+    };
+
+#ifdef IM_RICHTEXT_TARGET_IMGUI
+    static thread_local ConfigStackCache<ImGuiContext> ImCurrentConfigs;
+#endif
+#ifdef IM_RICHTEXT_TARGET_BLEND2D
+    static thread_local ConfigStackCache<BLContext> BLCurrentConfigs;
+#endif
+
+    // Alpha weights of a Gaussian blurred rectangle's corner, sampled on a coarse regular grid 
+    // spanning the falloff across the edge (and the corner radius). The grid is mirrored
+    // for all four corners, and interpolated across the straight edges and interior.
+    struct GaussianShadow
+    {
+        static constexpr int Samples = 4;
+
+        float alpha[Samples + 1][Samples + 1];
+        float extent = 0.f;
+        float radius = 0.f;
+    };
+
+    struct LayoutJob;
+
+    static std::atomic<std::size_t> NextContextId{ 1 };
+
+    struct Context
+    {
+        // Using std::deque as a stable vector, as in-progress layouts refer to the slot's drawables
+        std::deque<RichTextSlot> RichTextSlots;
+        std::vector<std::size_t> FreeRichTextSlots;
+        std::unordered_map<std::size_t, std::unique_ptr<LayoutJob>> LayoutJobs;
+        std::unordered_map<std::size_t, std::vector<std::weak_ptr<SharedLayout>>> SharedLayouts;
+
+        std::size_t LayoutMemoryBudget = 0;
+        std::size_t LayoutIdleFrames = 60;
+        std::size_t LayoutFrame = 0;
+        LayoutCacheStats LayoutStats;
 
-    // Using std::deque as a stable vector, could be replaced
 #ifdef IM_RICHTEXT_TARGET_IMGUI
-    static std::unordered_map<ImGuiContext*, std::deque<RenderConfig>> ImRenderConfigs;
+        std::unordered_map<ImGuiContext*, ConfigStack> ImRenderConfigs;
 #endif
 #ifdef IM_RICHTEXT_TARGET_BLEND2D
-    static std::unordered_map<BLContext*, std::deque<RenderConfig>> BLRenderConfigs;
+        std::unordered_map<BLContext*, ConfigStack> BLRenderConfigs;
+#endif
+
+        // Gaussian shadows used by BoxShadowQuality::High, keyed by quantized blur and corner radius
+        std::unordered_map<uint32_t, GaussianShadow> ShadowCache;
+
+#ifdef IM_RICHTEXT_ENABLE_PROFILING
+        ProfileCounters FrameProfile; // Counts of current frame
+        ProfileCounters LastFrameProfile; // Counts of last complete frame
+#endif
+#ifdef IM_RICHTEXT_BUNDLED_FONTLOADER
+        FontContext* Fonts = nullptr; // Owned, the default font context is used if null
+#endif
+        std::size_t Id = NextContextId++;
+
+        ~Context(); // Defined once LayoutJob is complete
+    };
+
+    // Used by threads which have not set a context
+    static Context DefaultContext;
+    static thread_local Context* CurrentContext = nullptr;
+
+    static Context& GetContext()
+    {
+        return CurrentContext != nullptr ? *CurrentContext : DefaultContext;
+    }
+
+    static RichTextData* FindRichText(std::size_t richTextId)
+    {
+        auto& g = GetContext();
+        auto index = richTextId & RichTextSlotMask;
+        if (index >= g.RichTextSlots.size()) return nullptr;
+
+        auto& slot = g.RichTextSlots[index];
+        return slot.alive && slot.generation == (richTextId >> RichTextSlotBits) ? &slot.data : nullptr;
+    }
+
+    static Drawables& GetLayout(RichTextData& data)
+    {
+        return data.sharedLayout ? data.sharedLayout->drawables : data.drawables;
+    }
+
+    static const Drawables& GetLayout(const RichTextData& data)
+    {
+        return data.sharedLayout ? data.sharedLayout->drawables : data.drawables;
+    }
+
+#ifdef IM_RICHTEXT_ENABLE_PROFILING
+    static ProfilerHooks Profiler;
+    static thread_local ProfileCounters* ActiveProfile = nullptr;
+    static thread_local std::size_t ActiveRichTextId = 0;
+
+    struct TraceEvent
+    {
+        ProfilePhase phase;
+        int line;
+        std::size_t richTextId;
+        std::size_t bytes;
+        std::size_t measurements;
+        long long start; // Nanoseconds since trace started
+        long long duration;
+    };
+
+    // Single producer (the owning thread), single consumer (FlushTrace, under TraceMutex) ring.
+    // The producer flags the ring while recording, so that the ring is only reset by StartTrace 
+    // (or flushed for the last time by StopTrace) once it is not being written to.
+    struct TraceRing
+    {
+        std::vector<TraceEvent> events;
+        std::atomic<std::size_t> head{ 0 }, tail{ 0 };
+        std::atomic<std::size_t> dropped{ 0 };
+        std::atomic<bool> recording{ false };
+        int tid = 0;
+    };
+
+    static std::mutex TraceMutex;
+    static std::vector<std::unique_ptr<TraceRing>> TraceRings; // Never shrinks, rings are owned by threads
+    static std::atomic<bool> TraceActive{ false };
+    static std::size_t TraceRingSize = 0;
+    static std::chrono::steady_clock::time_point TraceEpoch;
+    static FILE* TraceFile = nullptr;
+    static bool TraceFirstEvent = true;
+    static thread_local TraceRing* ThreadTraceRing = nullptr;
+    static thread_local std::size_t ThreadMeasurements = 0;
+
+    static TraceRing* GetThreadTraceRing()
+    {
+        if (ThreadTraceRing == nullptr)
+        {
+            std::lock_guard<std::mutex> lock{ TraceMutex };
+            auto& ring = TraceRings.emplace_back(std::make_unique<TraceRing>());
+            ring->events.resize(TraceRingSize);
+            ring->tid = (int)TraceRings.size();
+            ThreadTraceRing = ring.get();
+        }
+
+        return ThreadTraceRing;
+    }
+
+    // Pairs with the flag of the producer, i.e. either the producer observes that tracing was
+    // stopped, or this waits until it has finished recording
+    static void WaitForTraceProducers()
+    {
+        for (auto& ring : TraceRings)
+            while (ring->recording.load()) std::this_thread::yield();
+    }
+
+    static void RecordTraceEvent(const ProfileScope& scope, long long elapsed, std::size_t richTextId)
+    {
+        auto ring = GetThreadTraceRing();
+        ring->recording.store(true);
+
+        // The ring (and epoch) are set up by StartTrace before tracing is activated
+        if (!TraceActive.load())
+        {
+            ring->recording.store(false, std::memory_order_release);
+            return;
+        }
+
+        auto head = ring->head.load(std::memory_order_relaxed);
+        auto capacity = ring->events.size();
+
+        if (capacity == 0 || head - ring->tail.load(std::memory_order_acquire) >= capacity)
+        {
+            ring->dropped.fetch_add(1, std::memory_order_relaxed);
+            ring->recording.store(false, std::memory_order_release);
+            return;
+        }
+
+        auto& event = ring->events[head % capacity];
+        event.phase = scope.phase;
+        event.line = scope.line;
+        event.richTextId = richTextId;
+        event.bytes = scope.bytes;
+        event.measurements = ThreadMeasurements - scope.measurements;
+        event.start = std::chrono::duration_cast<std::chrono::nanoseconds>(scope.start - TraceEpoch).count();
+        event.duration = elapsed;
+        ring->head.store(head + 1, std::memory_order_release);
+        ring->recording.store(false, std::memory_order_release);
+    }
+
+    ProfileScope::ProfileScope(ProfilePhase phase, std::size_t bytes)
+        : phase{ phase }, bytes{ bytes }, measurements{ ThreadMeasurements }
+    {
+        if (Profiler.BeginZone != nullptr) Profiler.BeginZone(phase, ActiveRichTextId, Profiler.UserData);
+        start = std::chrono::steady_clock::now();
+    }
+
+    ProfileScope::~ProfileScope()
+    {
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+
+        for (auto counters : { &GetContext().FrameProfile, ActiveProfile })
+        {
+            if (counters == nullptr) continue;
+
+            auto& counter = counters->phases[(int)phase];
+            counter.nanoseconds += elapsed;
+            counter.calls++;
+            counter.bytes += bytes;
+        }
+
+        // Measurements are too frequent to be traced individually, they are counted instead
+        if (phase == ProfilePhase::Measurement) ThreadMeasurements++;
+        else if (phase != ProfilePhase::Segmentation && TraceActive.load(std::memory_order_relaxed))
+            RecordTraceEvent(*this, elapsed, ActiveRichTextId);
+
+        if (Profiler.EndZone != nullptr) Profiler.EndZone(phase, ActiveRichTextId, Profiler.UserData);
+    }
+
+    bool StartTrace(const char* path, std::size_t eventsPerThread)
+    {
+        StopTrace();
+        std::lock_guard<std::mutex> lock{ TraceMutex };
+        WaitForTraceProducers();
+
+        TraceFile = std::fopen(path, "w");
+        if (TraceFile == nullptr) return false;
+
+        // JSON array format, which remains loadable without the closing bracket
+        std::fprintf(TraceFile, "[");
+        TraceFirstEvent = true;
+        TraceRingSize = eventsPerThread;
+        TraceEpoch = std::chrono::steady_clock::now();
+
+        for (auto& ring : TraceRings)
+        {
+            ring->events.resize(eventsPerThread);
+            ring->head.store(0);
+            ring->tail.store(0);
+            ring->dropped.store(0);
+        }
+
+        TraceActive.store(true);
+        return true;
+    }
+
+    void FlushTrace()
+    {
+        std::lock_guard<std::mutex> lock{ TraceMutex };
+        if (TraceFile == nullptr) return;
+
+        for (auto& ring : TraceRings)
+        {
+            auto tail = ring->tail.load(std::memory_order_relaxed);
+            auto head = ring->head.load(std::memory_order_acquire);
+            auto capacity = ring->events.size();
+
+            for (; tail != head; ++tail)
+            {
+                const auto& event = ring->events[tail % capacity];
+                std::fprintf(TraceFile, "%s\n{\"name\":\"%s\",\"cat\":\"imrichtext\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+                    "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"richText\":%zu,\"bytes\":%zu,\"measurements\":%zu,\"line\":%d}}",
+                    TraceFirstEvent ? "" : ",", GetProfilePhaseName(event.phase), ring->tid, (double)event.start / 1000.0,
+                    (double)event.duration / 1000.0, event.richTextId, event.bytes, event.measurements, event.line);
+                TraceFirstEvent = false;
+            }
+
+            ring->tail.store(tail, std::memory_order_release);
+
+            auto dropped = ring->dropped.exchange(0, std::memory_order_relaxed);
+            if (dropped > 0)
+            {
+                std::fprintf(TraceFile, "%s\n{\"name\":\"Dropped\",\"ph\":\"C\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,"
+                    "\"args\":{\"events\":%zu}}", TraceFirstEvent ? "" : ",", ring->tid, 
+                    (double)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - TraceEpoch).count() / 1000.0, dropped);
+                TraceFirstEvent = false;
+            }
+        }
+
+        std::fflush(TraceFile);
+    }
+
+    void StopTrace()
+    {
+        if (!TraceActive.exchange(false)) return;
+
+        {
+            std::lock_guard<std::mutex> lock{ TraceMutex };
+            WaitForTraceProducers();
+        }
+
+        FlushTrace();
+
+        std::lock_guard<std::mutex> lock{ TraceMutex };
+        std::fprintf(TraceFile, "\n]\n");
+        std::fclose(TraceFile);
+        TraceFile = nullptr;
+    }
+
+    // Attributes phases in its scope to a rich text
+    struct ProfileTarget
+    {
+        ProfileCounters* previous = ActiveProfile;
+        std::size_t previousId = ActiveRichTextId;
+
+        ProfileTarget(std::size_t richTextId, ProfileCounters& counters)
+        {
+            ActiveProfile = &counters;
+            ActiveRichTextId = richTextId;
+        }
+
+        ~ProfileTarget()
+        {
+            ActiveProfile = previous;
+            ActiveRichTextId = previousId;
+        }
+    };
+
+#define IM_RICHTEXT_PROFILE_TARGET(ID, COUNTERS) ProfileTarget _profileTarget{ ID, COUNTERS }
+#else
+#define IM_RICHTEXT_PROFILE_TARGET(ID, COUNTERS)
 #endif
 
     static const ListItemTokenDescriptor InvalidListItemToken{};
@@ -146,8 +564,20 @@ namespace ImRichText
     static const DrawableBlock InvalidBgBlock{};
 
     // String representation of numbers, std::string_view is constructed from
-    // these strings and used for <li> in <ol> lists
-    static std::vector<std::string> NumbersAsStr;
+    // these strings and used for <li> in <ol> lists. Immutable, hence shared by contexts.
+    static const std::vector<std::string>& GetNumbersAsStr()
+    {
+        static const std::vector<std::string> numbers = [] {
+            std::vector<std::string> result;
+            result.reserve(IM_RICHTEXT_MAX_LISTITEM);
+
+            for (auto num = 1; num <= IM_RICHTEXT_MAX_LISTITEM; ++num)
+                result.emplace_back(std::to_string(num));
+            return result;
+        }();
+
+        return numbers;
+    }
 
 #ifdef IM_RICHTEXT_TARGET_IMGUI
 #ifdef _DEBUG
@@ -181,9 +611,20 @@ namespace ImRichText
         float _maxWidth = 0.f;
         Operation _lastOp = Operation::None;
         ImVec2 _bounds;
+        bool _measureOnly = false;
+
+        // Incremental layout, lines/blocks before these indices are final
+        float _suspendHeight = -1.f;
+        std::chrono::steady_clock::time_point _suspendTime = std::chrono::steady_clock::time_point::max();
+        int _finalizedLines = 0;
+        int _finalizedBlocks[IM_RICHTEXT_MAXDEPTH] = { 0 };
+        int _dirtyLine = -1; // First line of the background spans closed since last geometry update
+        int _releasedLines = 0, _nextRelease = 32; // Measurement only, see ReleaseMeasuredLines()
 
         const RenderConfig& _config;
         Drawables& _result;
+        LayoutTape* _tape = nullptr; // Callbacks are recorded into it, if set
+        std::vector<ImVec2> _measured; // Batch measurement of replayed words
 
         DrawableLine _currLine;
         StyleDescriptor _currStyle;
@@ -223,10 +664,14 @@ namespace ImRichText
             --_currentStackPos;
         }
 
-        void AddToken(Token token, int propsChanged);
+        void AddToken(Token token, int propsChanged, const ImVec2* measured = nullptr);
         SegmentData& AddSegment();
         SegmentData& AddSegment(DrawableLine& line, int styleIdx);
-        void GenerateTextToken(std::string_view content);
+        void GenerateTextToken(std::string_view content, const ImVec2* measured = nullptr);
+        void BeginContent();
+        void AddLineBreak();
+        void RecordEvent(LayoutTape::EventType type, std::string_view text = {},
+            std::optional<std::string_view> value = std::nullopt, bool selfTerminating = false);
         std::vector<TokenPositionRemapping> PerformWordWrap(int index);
         void UpdateBackgroundSpan(int startDepth, int lineIdx, const std::vector<TokenPositionRemapping>& remapping);
         void ComputeSuperSubscriptOffsets(const std::pair<int, int>& indexes);
@@ -234,6 +679,7 @@ namespace ImRichText
         void RecordBackgroundSpanStart();
         void RecordBackgroundSpanEnd(bool isTagStart, bool segmentAdded, int depth, bool includeChildren);
         DrawableLine MoveToNextLine(bool isTagStart, int depth);
+        void ReleaseMeasuredLines();
 
         float GetMaxSuperscriptOffset(const DrawableLine& line, float scale) const;
         float GetMaxSubscriptOffset(const DrawableLine& line, float scale) const;
@@ -245,7 +691,7 @@ namespace ImRichText
 
     public:
 
-        DefaultTagVisitor(const RenderConfig& cfg, Drawables& res, ImVec2 bounds);
+        DefaultTagVisitor(const RenderConfig& cfg, Drawables& res, ImVec2 bounds, bool measureOnly = false);
 
         bool TagStart(std::string_view tag);
         bool Attribute(std::string_view name, std::optional<std::string_view> value);
@@ -257,6 +703,19 @@ namespace ImRichText
         void Error(std::string_view tag);
         bool IsSelfTerminating(std::string_view tag) const;
         bool IsPreformattedContent(std::string_view tag) const;
+
+        // Lazy layout: parsing suspends once lines reach the given height (or once the time 
+        // budget is exhausted), and the lines laid out so far can be finalized and drawn.
+        bool ShouldSuspend() const;
+        void SuspendAt(float height) { _suspendHeight = height; }
+        void SuspendAfter(std::chrono::steady_clock::time_point deadline) { _suspendTime = deadline; }
+        void FinalizeLines(bool complete);
+        float LaidOutHeight() const;
+        int FinalizedLines() const { return _finalizedLines; }
+
+        // Records all callbacks into the tape, see ReplayLayoutTape
+        void RecordTape(LayoutTape* tape) { _tape = tape; }
+        bool ReplayContent(std::string_view content, const std::string_view* words, int count);
     };
 
     // ===============================================================
@@ -323,11 +782,13 @@ namespace ImRichText
             if (StartsWith(stylePropVal, "linear-gradient")) 
                 block.Gradient = ExtractLinearGradient(stylePropVal, config.NamedColor, config.UserData);
             else block.Color = ExtractColor(stylePropVal, config.NamedColor, config.UserData);
+            block.ColorSlot = PaletteSlot::None;
             prop = StyleBackground;
         }
         else if (AreSame(stylePropName, "color"))
         {
             style.fgcolor = ExtractColor(stylePropVal, config.NamedColor, config.UserData);
+            style.fgslot = PaletteSlot::None;
             prop = StyleFgColor;
         }
         else if (AreSame(stylePropName, "width"))
@@ -595,6 +1056,7 @@ namespace ImRichText
         result.font.size = config.DefaultFontSize * config.FontScale;
         result.font.font = GetFont(result.font.family, result.font.size, FT_Normal);
         result.fgcolor = config.DefaultFgColor;
+        result.fgslot = PaletteSlot::DefaultFg;
         result.list.itemStyle = config.ListItemBullet;
         return result;
     }
@@ -750,6 +1212,7 @@ namespace ImRichText
             if (AreSame(attribName, "color") && attribValue.has_value())
             {
                 style.fgcolor = ExtractColor(attribValue.value(), config.NamedColor, config.UserData);
+                style.fgslot = PaletteSlot::None;
                 result = result | StyleFgColor;
             }
             else if (AreSame(attribName, "size") && attribValue.has_value())
@@ -835,7 +1298,10 @@ namespace ImRichText
             if (tagType == TagType::CodeBlock)
             {
                 if ((style.propsSpecified & StyleBackground) == 0)
+                {
                     block.Color = config.CodeBlockBg;
+                    block.ColorSlot = PaletteSlot::CodeBlockBg;
+                }
             }
         }
         else if (tagType == TagType::Italics)
@@ -851,7 +1317,10 @@ namespace ImRichText
         else if (tagType == TagType::Mark)
         {
             if ((style.propsSpecified & StyleBackground) == 0)
+            {
                 block.Color = config.MarkHighlight;
+                block.ColorSlot = PaletteSlot::MarkHighlight;
+            }
             style.propsSpecified = style.propsSpecified | StyleBackground;
         }
         else if (tagType == TagType::Small)
@@ -882,7 +1351,11 @@ namespace ImRichText
         else if (tagType == TagType::Hyperlink)
         {
             if ((style.propsSpecified & StyleFontStyle) == 0) style.font.flags |= FontStyleUnderline;
-            if ((style.propsSpecified & StyleFgColor) == 0) style.fgcolor = config.HyperlinkColor;
+            if ((style.propsSpecified & StyleFgColor) == 0)
+            {
+                style.fgcolor = config.HyperlinkColor;
+                style.fgslot = PaletteSlot::Hyperlink;
+            }
             style.propsSpecified = style.propsSpecified | StyleFontStyle | StyleFgColor;
         }
         else if (tagType == TagType::Blink)
@@ -941,6 +1414,41 @@ namespace ImRichText
 #define DrawBoundingBox(...)
 #endif
 
+    template <typename T>
+    static void HashCombine(std::size_t& hash, const T& value)
+    {
+        hash = (hash * 31u) ^ std::hash<T>()(value);
+    }
+
+    static uint32_t ResolveColor(uint32_t color, PaletteSlot slot, const RenderConfig& config)
+    {
+        switch (slot)
+        {
+        case PaletteSlot::DefaultFg: return config.DefaultFgColor;
+        case PaletteSlot::Hyperlink: return config.HyperlinkColor;
+        case PaletteSlot::HeaderLine: return config.HeaderLineColor;
+        case PaletteSlot::MarkHighlight: return config.MarkHighlight;
+        case PaletteSlot::CodeBlockBg: return config.CodeBlockBg;
+        default: return color;
+        }
+    }
+
+    // Hashes the colors which are only resolved when drawing, see PaletteSlot
+    static std::size_t GetPaletteFingerprint(const RenderConfig& config)
+    {
+        std::size_t hash = 0;
+        HashCombine(hash, config.DefaultFgColor);
+        HashCombine(hash, config.DefaultBgColor);
+        HashCombine(hash, config.HyperlinkColor);
+        HashCombine(hash, config.HeaderLineColor);
+        HashCombine(hash, config.MarkHighlight);
+        HashCombine(hash, config.CodeBlockBg);
+        HashCombine(hash, config.MeterBorderColor);
+        HashCombine(hash, config.MeterBgColor);
+        HashCombine(hash, config.MeterFgColor);
+        return hash != 0 ? hash : 1u;
+    }
+
     template <typename ItrT>
     static void DrawLinearGradient(ImVec2 initpos, ImVec2 endpos, float angle, ImGuiDir dir, ItrT start, ItrT end, const RenderConfig& config)
     {
@@ -990,14 +1498,28 @@ namespace ImRichText
         }
     }
 
+    static void DrawBorderSide(const Border& border, ImVec2 startpos, ImVec2 endpos, uint32_t bgcolor, 
+        const RenderConfig& config)
+    {
+        if (border.thickness > 0.f && border.color != bgcolor && IsColorVisible(border.color))
+        {
+            if (border.lineType == LineType::Solid)
+                config.Renderer->DrawLine(startpos, endpos, border.color, border.thickness);
+            else
+                config.Renderer->DrawPatternLine(startpos, endpos, border.color, border.lineType, border.thickness);
+        }
+    }
+
     static void DrawBorderRect(const FourSidedBorder& border, ImVec2 startpos, ImVec2 endpos,
         uint32_t bgcolor, const RenderConfig& config)
     {
         if (border.isUniform && border.top.thickness > 0.f && IsColorVisible(border.top.color) &&
             border.top.color != bgcolor)
         {
+            // NOTE: Dashed/dotted borders with rounded corners are drawn as solid
             if (!border.isRounded())
-                config.Renderer->DrawRect(startpos, endpos, border.top.color, false, border.top.thickness);
+                config.Renderer->DrawPatternRect(startpos, endpos, border.top.color, border.top.lineType, 
+                    border.top.thickness);
             else
                 config.Renderer->DrawRoundedRect(startpos, endpos, border.top.color, false,
                     border.cornerRadius[TopLeftCorner], border.cornerRadius[TopRightCorner],
@@ -1008,17 +1530,152 @@ namespace ImRichText
         {
             auto width = endpos.x - startpos.x, height = endpos.y - startpos.y;
 
-            if (border.top.thickness > 0.f && border.top.color != bgcolor && IsColorVisible(border.top.color))
-                config.Renderer->DrawLine(startpos, startpos + ImVec2{ width, 0.f }, border.top.color, border.top.thickness);
-            if (border.right.thickness > 0.f && border.right.color != bgcolor && IsColorVisible(border.right.color))
-                config.Renderer->DrawLine(startpos + ImVec2{ width - border.right.thickness, 0.f }, endpos -
-                    ImVec2{ border.right.thickness, 0.f }, border.right.color, border.right.thickness);
-            if (border.left.thickness > 0.f && border.left.color != bgcolor && IsColorVisible(border.left.color))
-                config.Renderer->DrawLine(startpos, startpos + ImVec2{ 0.f, height }, border.left.color, border.left.thickness);
-            if (border.bottom.thickness > 0.f && border.bottom.color != bgcolor && IsColorVisible(border.bottom.color))
-                config.Renderer->DrawLine(startpos + ImVec2{ 0.f, height - border.bottom.thickness }, endpos -
-                    ImVec2{ 0.f, border.bottom.thickness }, border.bottom.color, border.bottom.thickness);
+            DrawBorderSide(border.top, startpos, startpos + ImVec2{ width, 0.f }, bgcolor, config);
+            DrawBorderSide(border.right, startpos + ImVec2{ width - border.right.thickness, 0.f }, 
+                endpos - ImVec2{ border.right.thickness, 0.f }, bgcolor, config);
+            DrawBorderSide(border.left, startpos, startpos + ImVec2{ 0.f, height }, bgcolor, config);
+            DrawBorderSide(border.bottom, startpos + ImVec2{ 0.f, height - border.bottom.thickness }, 
+                endpos - ImVec2{ 0.f, border.bottom.thickness }, bgcolor, config);
+        }
+    }
+
+    static void DrawShadowRect(const ImRect& rect, uint32_t color, const FourSidedBorder& border, const RenderConfig& config)
+    {
+        if (!border.isRounded())
+            config.Renderer->DrawRect(rect.Min, rect.Max, color, true);
+        else
+            config.Renderer->DrawRoundedRect(rect.Min, rect.Max, color, true,
+                border.cornerRadius[TopLeftCorner], border.cornerRadius[TopRightCorner],
+                border.cornerRadius[BottomRightCorner], border.cornerRadius[BottomLeftCorner]);
+    }
+
+    // Fraction of a gaussian blurred edge covering a point at (signed) distance `dist` inside it
+    static float GaussianCoverage(float dist, float sigma)
+    {
+        return 0.5f * (1.f + std::erf(dist / (sigma * 1.41421356f)));
+    }
+
+    // Blurred coverage of a (rounded) rect at offset (x, y) from its center
+    static float GaussianShadowAlpha(float x, float y, ImVec2 halfsz, float radius, float sigma)
+    {
+        if (radius <= 0.f)
+        {
+            // Blurring a sharp rect is separable along both axes
+            return (GaussianCoverage(x + halfsz.x, sigma) - GaussianCoverage(x - halfsz.x, sigma)) *
+                (GaussianCoverage(y + halfsz.y, sigma) - GaussianCoverage(y - halfsz.y, sigma));
+        }
+
+        // Approximate rounded rects from their signed distance, positive outside
+        radius = std::min({ radius, halfsz.x, halfsz.y });
+        auto qx = std::fabs(x) - halfsz.x + radius, qy = std::fabs(y) - halfsz.y + radius;
+        auto ox = std::max(qx, 0.f), oy = std::max(qy, 0.f);
+        auto dist = std::sqrt(ox * ox + oy * oy) + std::min(std::max(qx, qy), 0.f) - radius;
+        return GaussianCoverage(-dist, sigma);
+    }
+
+    static const GaussianShadow& GetGaussianShadow(float blur, float radius)
+    {
+        auto& g = GetContext();
+        // Quantize to half pixels, so that similar shadows share the same entry
+        auto qblur = (uint32_t)std::min(blur * 2.f + 0.5f, 65535.f);
+        auto qradius = (uint32_t)std::min(radius * 2.f + 0.5f, 65535.f);
+        auto it = g.ShadowCache.find((qblur << 16) | qradius);
+        if (it != g.ShadowCache.end()) return it->second;
+
+        auto& result = g.ShadowCache[(qblur << 16) | qradius];
+        auto sigma = (float)qblur * 0.25f; // CSS defines blur radius as twice the standard deviation
+        result.radius = (float)qradius * 0.5f;
+        result.extent = 3.f * sigma;
+
+        // Sample the top-left corner of a rect large enough for the far edges to not contribute
+        auto step = (2.f * result.extent + result.radius) / (float)GaussianShadow::Samples;
+        auto halfsz = 2.f * result.extent + result.radius;
+
+        for (auto row = 0; row <= GaussianShadow::Samples; ++row)
+            for (auto col = 0; col <= GaussianShadow::Samples; ++col)
+                result.alpha[row][col] = GaussianShadowAlpha(-halfsz - result.extent + step * (float)col,
+                    -halfsz - result.extent + step * (float)row, ImVec2{ halfsz, halfsz }, result.radius, sigma);
+
+        return result;
+    }
+
+    // Draws the blurred shadow rect as a single vertex colored mesh. The corner falloff is
+    // cached, unless the rect is too small for its corners to be apart, in which case the
+    // coverage is evaluated for each vertex of the mesh. The grid (and hence the indices)
+    // is the same for all shadows.
+    // The grid is a nine-slice: 4 corners of Samples x Samples quads, 4 edge ramps of Samples
+    // quads and a single flat quad for the interior. A corner or edge of a single bilinear quad
+    // cannot follow the gaussian (or rounded) falloff, that is what BoxShadowQuality::Fast draws.
+    static void DrawGaussianShadow(const ImRect& rect, float blur, float radius, uint32_t color, 
+        const RenderConfig& config)
+    {
+        constexpr int Samples = GaussianShadow::Samples;
+        constexpr int GridSize = 2 * (Samples + 1);
+        constexpr int IndexCount = (GridSize - 1) * (GridSize - 1) * 6;
+
+        static const auto indices = [] {
+            std::array<uint32_t, IndexCount> result{};
+            auto idxcount = 0;
+
+            for (auto row = 0; row < GridSize - 1; ++row)
+            {
+                for (auto col = 0; col < GridSize - 1; ++col)
+                {
+                    auto topleft = (uint32_t)(row * GridSize + col);
+                    result[idxcount++] = topleft;
+                    result[idxcount++] = topleft + 1;
+                    result[idxcount++] = topleft + GridSize + 1;
+                    result[idxcount++] = topleft;
+                    result[idxcount++] = topleft + GridSize + 1;
+                    result[idxcount++] = topleft + GridSize;
+                }
+            }
+
+            return result;
+        }();
+
+        const auto& shadow = GetGaussianShadow(blur, radius);
+        auto extent = shadow.extent, span = 2.f * shadow.extent + shadow.radius;
+        auto halfsz = rect.GetSize() * 0.5f;
+        auto center = rect.GetCenter();
+        auto cached = (halfsz.x >= span - extent) && (halfsz.y >= span - extent);
+
+        ImVec2 positions[GridSize * GridSize];
+        uint32_t colors[GridSize * GridSize];
+
+        // Grid lines of the near corners, followed by mirrored grid lines of the far corners,
+        // which meet at the center for small rects
+        float xs[GridSize], ys[GridSize];
+        int samples[GridSize];
+        auto stepx = std::min(span, halfsz.x + extent) / (float)Samples;
+        auto stepy = std::min(span, halfsz.y + extent) / (float)Samples;
+
+        for (auto idx = 0; idx <= Samples; ++idx)
+        {
+            xs[idx] = rect.Min.x - extent + stepx * (float)idx;
+            ys[idx] = rect.Min.y - extent + stepy * (float)idx;
+            xs[GridSize - 1 - idx] = rect.Max.x + extent - stepx * (float)idx;
+            ys[GridSize - 1 - idx] = rect.Max.y + extent - stepy * (float)idx;
+            samples[idx] = samples[GridSize - 1 - idx] = idx;
+        }
+
+        auto alpha = (float)((color & IM_COL32_A_MASK) >> IM_COL32_A_SHIFT);
+        auto rgb = color & ~IM_COL32_A_MASK;
+        auto sigma = blur * 0.5f;
+
+        for (auto row = 0; row < GridSize; ++row)
+        {
+            for (auto col = 0; col < GridSize; ++col)
+            {
+                auto vtx = row * GridSize + col;
+                auto weight = cached ? shadow.alpha[samples[row]][samples[col]] :
+                    GaussianShadowAlpha(xs[col] - center.x, ys[row] - center.y, halfsz, radius, sigma);
+                positions[vtx] = ImVec2{ xs[col], ys[row] };
+                colors[vtx] = rgb | ((uint32_t)(alpha * weight + 0.5f) << IM_COL32_A_SHIFT);
+            }
         }
+
+        config.Renderer->DrawMesh(positions, colors, GridSize * GridSize, indices.data(), IndexCount, ImVec2{ 0.f, 0.f });
     }
 
     static void DrawBoxShadow(ImVec2 startpos, ImVec2 endpos, const BoxShadow& shadow, 
@@ -1037,7 +1694,15 @@ namespace ImRichText
             rect.Expand(shadow.spread);
             rect.Translate(shadow.offset);
 
-            if (shadow.blur > 0.f)
+            // As per CSS, spread also grows the corner radius of rounded boxes
+            auto shadowRadius = std::max({ border.cornerRadius[TopLeftCorner], border.cornerRadius[TopRightCorner],
+                border.cornerRadius[BottomRightCorner], border.cornerRadius[BottomLeftCorner] });
+            if (shadowRadius > 0.f) shadowRadius = std::max(shadowRadius + shadow.spread, 0.f);
+
+            // The gaussian mesh covers the interior of the shadow as well
+            if (shadow.blur > 0.f && config.ShadowQuality == BoxShadowQuality::High)
+                DrawGaussianShadow(rect, shadow.blur, shadowRadius, shadow.color, config);
+            else if (shadow.blur > 0.f)
             {
                 auto outercol = shadow.color & ~IM_COL32_A_MASK;
                 auto brk = ComputeRectBreakups(rect, shadow.blur);
@@ -1109,15 +1774,12 @@ namespace ImRichText
                 default:
                     break;
                 }
-            }
 
-            rect.Expand(shadow.blur > 0.f ? 1.f : 0.f);
-            if (!border.isRounded())
-                config.Renderer->DrawRect(rect.Min, rect.Max, shadow.color, true);
+                rect.Expand(1.f);
+                DrawShadowRect(rect, shadow.color, border, config);
+            }
             else
-                config.Renderer->DrawRoundedRect(rect.Min, rect.Max, shadow.color, true,
-                    border.cornerRadius[TopLeftCorner], border.cornerRadius[TopRightCorner],
-                    border.cornerRadius[BottomRightCorner], border.cornerRadius[BottomLeftCorner]);
+                DrawShadowRect(rect, shadow.color, border, config);
 
             auto diffcolor = config.DefaultBgColor >> 1;
             border.setColor(config.DefaultBgColor);
@@ -1201,8 +1863,8 @@ namespace ImRichText
             constexpr int bufsz = 4096;
             char buffer[bufsz] = { 0 };
             auto yesorno = [](bool val) { return val ? "Yes" : "No"; };
-            auto [fr, fg, fb] = DecomposeToRGBChannels(style.fgcolor);
-            auto [br, bg, bb] = DecomposeToRGBChannels(block.Color);
+            auto [fr, fg, fb] = DecomposeToRGBChannels(ResolveColor(style.fgcolor, style.fgslot, config));
+            auto [br, bg, bb] = DecomposeToRGBChannels(ResolveColor(block.Color, block.ColorSlot, config));
 
             currpos = std::snprintf(buffer, bufsz - 1, "Position            : (%.2f, %.2f)\n"
                 "Bounds              : (%.2f, %.2f)\n",
@@ -1303,16 +1965,17 @@ namespace ImRichText
     static bool DrawToken(const Token& token, ImVec2 initpos,
         ImVec2 bounds, const StyleDescriptor& style, const TagPropertyDescriptor& tagprops, 
         const DrawableBlock& block, const ListItemTokenDescriptor& listItem, 
-        const RenderConfig& config, TooltipData& tooltip, AnimationData& animation)
+        const RenderConfig& config, AnimationData& animation)
     {
         auto startpos = token.Bounds.start(initpos) + ImVec2{ token.Offset.left, token.Offset.top };
         auto endpos = token.Bounds.end(initpos);
+        auto fgcolor = ResolveColor(style.fgcolor, style.fgslot, config);
 
         if ((style.blink && animation.isVisible) || !style.blink)
         {
             if (token.Type == TokenType::HorizontalRule)
             {
-                config.Renderer->DrawRect(startpos, endpos, style.fgcolor, true);
+                config.Renderer->DrawRect(startpos, endpos, fgcolor, true);
             }
             else if (token.Type == TokenType::ListItemBullet)
             {
@@ -1320,12 +1983,12 @@ namespace ImRichText
                 auto bulletsz = (style.font.size) / bulletscale;
 
                 if (style.list.itemStyle == BulletType::Custom)
-                    config.Renderer->DrawBullet(startpos, endpos, style.fgcolor, listItem.ListItemIndex, listItem.ListDepth);
-                else config.Renderer->DrawDefaultBullet(style.list.itemStyle, initpos, token.Bounds, style.fgcolor, bulletsz);
+                    config.Renderer->DrawBullet(startpos, endpos, fgcolor, listItem.ListItemIndex, listItem.ListDepth);
+                else config.Renderer->DrawDefaultBullet(style.list.itemStyle, initpos, token.Bounds, fgcolor, bulletsz);
             }
             else if (token.Type == TokenType::ListItemNumbered)
             {
-                config.Renderer->DrawText(listItem.NestedListItemIndex, startpos, style.fgcolor);
+                config.Renderer->DrawText(listItem.NestedListItemIndex, startpos, fgcolor);
             }
             else if (token.Type == TokenType::Meter)
             {
@@ -1343,49 +2006,21 @@ namespace ImRichText
             {
                 auto textend = token.Content.data() + token.VisibleTextSize;
                 auto halfh = token.Bounds.height * 0.5f;
-                config.Renderer->DrawText(token.Content, startpos, style.fgcolor);
+                config.Renderer->DrawText(token.Content, startpos, fgcolor);
 
                 if (token.Type == TokenType::ElidedText)
                 {
                     auto ewidth = config.Renderer->EllipsisWidth(style.font.font, style.font.size);
-                    config.Renderer->DrawText("...", ImVec2{ startpos.x + token.Bounds.width - ewidth, startpos.y }, style.fgcolor);
+                    config.Renderer->DrawText("...", ImVec2{ startpos.x + token.Bounds.width - ewidth, startpos.y }, fgcolor);
                 }
 
-                if (style.font.flags & FontStyleStrikethrough) config.Renderer->DrawLine(startpos + ImVec2{ 0.f, halfh }, endpos + ImVec2{ 0.f, -halfh }, style.fgcolor);
-                if (style.font.flags & FontStyleUnderline) config.Renderer->DrawLine(startpos + ImVec2{ 0.f, token.Bounds.height }, endpos, style.fgcolor);
-
-                if (!tagprops.tooltip.empty())
-                {
-                    if (!(style.font.flags & FontStyleUnderline))
-                    {
-                        // TODO: Refactor this out
-                        auto posx = startpos.x;
-                        while (posx < endpos.x)
-                        {
-                            config.Renderer->DrawCircle(ImVec2{ posx, endpos.y }, 1.f, style.fgcolor, true);
-                            posx += 3.f;
-                        }
-                    }
+                if (style.font.flags & FontStyleStrikethrough) config.Renderer->DrawLine(startpos + ImVec2{ 0.f, halfh }, endpos + ImVec2{ 0.f, -halfh }, fgcolor);
+                if (style.font.flags & FontStyleUnderline) config.Renderer->DrawLine(startpos + ImVec2{ 0.f, token.Bounds.height }, endpos, fgcolor);
 
-                    auto mousepos = config.Platform->GetCurrentMousePos();
-                    if (ImRect{ startpos, endpos }.Contains(mousepos))
-                    {
-                        tooltip.pos = mousepos;
-                        tooltip.content = tagprops.tooltip;
-                    }
-                }
-                else if (!tagprops.link.empty() && (config.Platform != nullptr))
-                { 
-                    auto pos = config.Platform->GetCurrentMousePos();
-                    if (ImRect{ startpos, endpos }.Contains(pos))
-                    {
-                        config.Platform->HandleHover(true);
-                        if (config.Platform->IsMouseClicked())
-                            config.Platform->HandleHyperlink(tagprops.link);
-                    }
-                    else
-                        config.Platform->HandleHover(false);
-                }
+                // Hover, tooltips and hyperlinks are handled through the hit-test index in DrawImpl
+                if (!tagprops.tooltip.empty() && !(style.font.flags & FontStyleUnderline))
+                    config.Renderer->DrawPatternLine(ImVec2{ startpos.x, endpos.y }, endpos, fgcolor, 
+                        LineType::Dotted);
             }
         }
 
@@ -1399,7 +2034,7 @@ namespace ImRichText
 
     static bool DrawSegment(const SegmentData& segment, const DrawableBlock& block, 
         ImVec2 initpos, ImVec2 bounds, const Drawables& result, const RenderConfig& config, 
-        TooltipData& tooltip, AnimationData& animation)
+        AnimationData& animation)
     {
         if (segment.Tokens.empty()) return true;
         const auto& style = result.StyleDescriptors[segment.StyleIdx + 1];
@@ -1422,7 +2057,7 @@ namespace ImRichText
             const auto& tagprops = token.PropertiesIdx == -1 ? InvalidTagPropDesc :
                 result.TagDescriptors[token.PropertiesIdx];
             if (drawTokens && !DrawToken(token, initpos, bounds, style,
-                tagprops, block, listItem, config, tooltip, animation))
+                tagprops, block, listItem, config, animation))
             {
                 drawTokens = false; 
                 break;
@@ -1434,42 +2069,104 @@ namespace ImRichText
         return drawTokens;
     }
 
-    static std::optional<std::pair<int, int>> GetBlockIndex(const Drawables& result, ImVec2 pos)
+    // Visits the intervals of [lo, hi) which start above `end` and contain pos.y, subtrees which 
+    // end above pos.y are skipped, hence only O(log n) intervals are visited per block found
+    static void FindBlockIndex(const Drawables& result, int lo, int hi, int end, ImVec2 pos, 
+        std::pair<int, int>& found)
     {
-        for (auto depth = 0; depth < IM_RICHTEXT_MAXDEPTH; ++depth)
+        if (lo >= hi || lo >= end) return;
+
+        auto mid = lo + (hi - lo) / 2;
+        const auto& interval = result.BlockIntervals[mid];
+        if (interval.maxBottom < pos.y) return;
+
+        FindBlockIndex(result, lo, mid, end, pos, found);
+        if (mid >= end) return;
+
+        if (interval.bottom >= pos.y)
         {
-            auto blockidx = 0;
-            for (const auto& block : result.BackgroundBlocks[depth])
-            {
-                if (ImRect{ block.Start, block.End }.Contains(pos))
-                    return std::make_pair(depth, blockidx);
-                blockidx++;
-            }
+            const auto& block = result.BackgroundBlocks[interval.depth][interval.index];
+            if (pos.x >= block.Start.x && pos.x <= block.End.x && (found.first == -1 || 
+                std::make_pair(interval.depth, interval.index) < found))
+                found = std::make_pair(interval.depth, interval.index);
         }
 
-        return std::nullopt;
+        FindBlockIndex(result, mid + 1, hi, end, pos, found);
     }
 
-    static void DrawForegroundLayer(ImVec2 initpos, ImVec2 bounds,
-        const Drawables& result, const RenderConfig& config, TooltipData& tooltip, 
-        AnimationData& animation)
+    // Background block containing pos (document coordinates), with the lowest depth
+    static std::pair<int, int> GetBlockIndex(const Drawables& result, ImVec2 pos)
+    {
+        const auto& intervals = result.BlockIntervals;
+        auto end = std::upper_bound(intervals.begin(), intervals.end(), pos.y,
+            [](float y, const BlockInterval& interval) { return y < interval.top; }) - intervals.begin();
+        std::pair<int, int> found{ -1, -1 };
+        FindBlockIndex(result, 0, (int)intervals.size(), (int)end, pos, found);
+        return found;
+    }
+
+    // Link/tooltip region containing pos (document coordinates), binary searched by line then
+    // by left edge, as neither lines nor tokens within a line overlap.
+    static int GetInteractiveRegion(const Drawables& result, ImVec2 pos, const AnimationData& animation)
     {
-        std::optional<std::pair<int, int>> bidx = std::nullopt;
-        if (config.Platform) bidx = GetBlockIndex(result, config.Platform->GetCurrentMousePos());
-        const auto& block = bidx != std::nullopt ? result.BackgroundBlocks[bidx.value().first][bidx.value().second] :
-            InvalidBgBlock;
         const auto& lines = result.ForegroundLines;
+        const auto& regions = result.InteractiveRegions;
+        if (regions.empty()) return -1;
 
-        for (auto lineidx = 0; lineidx < (int)lines.size(); ++lineidx)
+        auto lit = std::upper_bound(lines.begin(), lines.end(), pos.y,
+            [](float y, const DrawableLine& line) { return y < line.Content.top; });
+        if (lit == lines.begin()) return -1;
+
+        auto lineidx = (int)(lit - lines.begin()) - 1;
+        if (pos.y > lines[lineidx].Content.top + lines[lineidx].height()) return -1;
+
+        if (lines[lineidx].Marquee)
         {
-            auto segmentidx = 0;
-            if (lines[lineidx].Segments.empty()) continue;
+            auto mit = std::lower_bound(result.MarqueeLines.begin(), result.MarqueeLines.end(), lineidx);
+            auto marqueeidx = (std::size_t)(mit - result.MarqueeLines.begin());
+            if (marqueeidx < animation.xoffsets.size()) pos.x -= animation.xoffsets[marqueeidx];
+        }
 
-            for (const auto& segment : lines[lineidx].Segments)
-            {
+        auto first = std::lower_bound(regions.begin(), regions.end(), lineidx,
+            [](const InteractiveRegion& region, int idx) { return region.LineIdx < idx; });
+        auto last = std::upper_bound(first, regions.end(), lineidx,
+            [](int idx, const InteractiveRegion& region) { return idx < region.LineIdx; });
+        auto rit = std::upper_bound(first, last, pos.x,
+            [](float x, const InteractiveRegion& region) { return x < region.Bounds.left; });
+        if (rit == first) return -1;
+
+        --rit;
+        const auto& box = rit->Bounds;
+        return pos.x <= box.left + box.width && pos.y >= box.top && pos.y <= box.top + box.height ? 
+            (int)(rit - regions.begin()) : -1;
+    }
+
+    static void DrawForegroundLayer(ImVec2 initpos, ImVec2 bounds,
+        const Drawables& result, const RenderConfig& config, AnimationData& animation)
+    {
+        const auto& block = animation.hoveredBlock.first != -1 ? 
+            result.BackgroundBlocks[animation.hoveredBlock.first][animation.hoveredBlock.second] : InvalidBgBlock;
+        const auto& lines = result.ForegroundLines;
+        auto marqueeidx = 0;
+
+        for (auto lineidx = 0; lineidx < (int)lines.size(); ++lineidx)
+        {
+            auto segmentidx = 0;
+            auto xoffset = 0.f;
+
+            if (lines[lineidx].Marquee)
+            {
+                while (result.MarqueeLines[marqueeidx] < lineidx) ++marqueeidx;
+                xoffset = animation.xoffsets[marqueeidx];
+            }
+
+            if (lines[lineidx].Segments.empty()) continue;
+
+            for (const auto& segment : lines[lineidx].Segments)
+            {
                 auto linestart = initpos;
-                if (lines[lineidx].Marquee) linestart.x += animation.xoffsets[lineidx];
-                if (!DrawSegment(segment, block, linestart, bounds, result, config, tooltip, animation))
+                linestart.x += xoffset;
+                if (!DrawSegment(segment, block, linestart, bounds, result, config, animation))
                     break;
                 ++segmentidx;
             }
@@ -1483,15 +2180,18 @@ namespace ImRichText
         }
     }
 
+    static const int AllBlocks[IM_RICHTEXT_MAXDEPTH] = {};
+
     static void DrawBackgroundLayer(ImVec2 initpos, ImVec2 bounds,
-        const std::vector<DrawableBlock>* blocks, const RenderConfig& config)
+        const std::vector<DrawableBlock>* blocks, const int* from, const RenderConfig& config)
     {
         // Draw all shadows first, which will underlay the backgrounds, this is
         // because shadows do not add to the dimension of segments/lines
         for (auto depth = 0; depth < IM_RICHTEXT_MAXDEPTH; ++depth)
         {
-            for (const auto& block : blocks[depth])
+            for (auto blockidx = from[depth]; blockidx < (int)blocks[depth].size(); ++blockidx)
             {
+                const auto& block = blocks[depth][blockidx];
                 auto startpos = block.Start + initpos;
                 auto endpos = block.End + initpos;
                 DrawBoxShadow(startpos, endpos, block.Shadow, block.Border, config);
@@ -1502,21 +2202,218 @@ namespace ImRichText
         // Draw backgrounds on top of shadows
         for (auto depth = 0; depth < IM_RICHTEXT_MAXDEPTH; ++depth)
         {
-            for (const auto& block : blocks[depth])
+            for (auto blockidx = from[depth]; blockidx < (int)blocks[depth].size(); ++blockidx)
             {
+                const auto& block = blocks[depth][blockidx];
                 auto startpos = block.Start + initpos;
                 auto endpos = block.End + initpos;
-                DrawBackground(startpos, endpos, block.Gradient, block.Color, block.Border, config);
-                DrawBoundingBox(ContentTypeBg, startpos, endpos, config);
-                DrawBorderRect(block.Border, startpos, endpos, block.Color, config);
+                auto color = ResolveColor(block.Color, block.ColorSlot, config);
+                DrawBackground(startpos, endpos, block.Gradient, color, block.Border, config);
+                DrawBorderRect(block.Border, startpos, endpos, color, config);
                 if (block.End.y > (bounds.y + initpos.y)) break;
             }
         }
     }
 
+    // Background decorations only change on relayout, hence they are tessellated once
+    // relative to origin, and the draw pass only translates and submits the mesh. Blocks
+    // from the given indices onwards are appended, as layout can be performed in steps.
+    // As palette colors are baked into the mesh, it is rebuilt entirely once they change.
+    // Renderers without native per-vertex colors draw the blocks directly, hence no mesh is
+    // built for them, and it is rebuilt entirely if a mesh capable renderer draws it later.
+    static void AppendBackgroundMesh(Drawables& drawables, const int* from, const RenderConfig& config)
+    {
+        if (!config.Renderer->SupportsMeshes())
+        {
+            drawables.BackgroundMesh.clear();
+            drawables.MeshPalette = 0;
+            return;
+        }
+
+        auto palette = GetPaletteFingerprint(config);
+
+        if (drawables.MeshPalette != palette)
+        {
+            drawables.BackgroundMesh.clear();
+            drawables.MeshPalette = palette;
+            from = AllBlocks;
+        }
+
+        MeshRecorder recorder{ drawables.BackgroundMesh };
+        auto recordConfig = config;
+        recordConfig.Renderer = &recorder;
+        DrawBackgroundLayer(ImVec2{ 0.f, 0.f }, ImVec2{ FLT_MAX, FLT_MAX }, drawables.BackgroundBlocks, 
+            from, recordConfig);
+    }
+
+    static bool IsSameBox(const BoundedBox& lhs, const BoundedBox& rhs)
+    {
+        return lhs.left == rhs.left && lhs.top == rhs.top && lhs.width == rhs.width && lhs.height == rhs.height;
+    }
+
+    static void AddDamage(std::vector<BoundedBox>& damage, BoundedBox box, ImVec2 pos, ImVec2 bounds)
+    {
+        auto left = std::max(box.left, pos.x), top = std::max(box.top, pos.y);
+        auto right = std::min(box.left + box.width, pos.x + bounds.x);
+        auto bottom = std::min(box.top + box.height, pos.y + bounds.y);
+        if (right > left && bottom > top) damage.push_back(BoundedBox{ top, left, right - left, bottom - top });
+    }
+
+    // Collects damage from relayout, movement/resize and the animation steps of previous frame
+    static void BeginDamageFrame(AnimationData& animation, ImVec2 pos, ImVec2 bounds)
+    {
+        auto moved = animation.lastPos.x != pos.x || animation.lastPos.y != pos.y ||
+            animation.lastBounds.x != bounds.x || animation.lastBounds.y != bounds.y;
+        animation.damage.clear();
+
+        if (moved || animation.fullDamage)
+        {
+            if (animation.lastBounds.x > 0.f && animation.lastBounds.y > 0.f)
+                animation.damage.push_back(BoundedBox{ animation.lastPos.y, animation.lastPos.x,
+                    animation.lastBounds.x, animation.lastBounds.y });
+            animation.damage.push_back(BoundedBox{ pos.y, pos.x, bounds.x, bounds.y });
+        }
+        else
+        {
+            for (auto box : animation.layoutDamage)
+            {
+                box.left += pos.x; box.top += pos.y;
+                AddDamage(animation.damage, box, pos, bounds);
+            }
+
+            for (const auto& box : animation.pendingDamage)
+                AddDamage(animation.damage, box, pos, bounds);
+        }
+
+        animation.layoutDamage.clear();
+        animation.pendingDamage.clear();
+        animation.fullDamage = false;
+        animation.lastPos = pos;
+        animation.lastBounds = bounds;
+    }
+
+    static void RecordAnimatedContent(Drawables& drawables, int fromLine, int toLine)
+    {
+        for (auto lineidx = fromLine; lineidx < toLine; ++lineidx)
+        {
+            const auto& line = drawables.ForegroundLines[lineidx];
+            if (line.Marquee) drawables.MarqueeLines.push_back(lineidx);
+
+            for (auto segmentidx = 0; segmentidx < (int)line.Segments.size(); ++segmentidx)
+                if (drawables.StyleDescriptors[line.Segments[segmentidx].StyleIdx + 1].blink)
+                    drawables.BlinkSegments.emplace_back(lineidx, segmentidx);
+        }
+    }
+
+    // The root of [lo, hi) is its middle interval, which stores the maximum bottom within [lo, hi)
+    static float BuildBlockIntervalTree(std::vector<BlockInterval>& intervals, int lo, int hi)
+    {
+        if (lo >= hi) return -FLT_MAX;
+
+        auto mid = lo + (hi - lo) / 2;
+        auto left = BuildBlockIntervalTree(intervals, lo, mid);
+        auto right = BuildBlockIntervalTree(intervals, mid + 1, hi);
+        intervals[mid].maxBottom = std::max({ intervals[mid].bottom, left, right });
+        return intervals[mid].maxBottom;
+    }
+
+    static void CreateHitTestIndex(Drawables& drawables, int fromLine, int toLine)
+    {
+        drawables.BlockIntervals.clear();
+
+        for (auto lineidx = fromLine; lineidx < toLine; ++lineidx)
+        {
+            auto first = drawables.InteractiveRegions.size();
+
+            for (const auto& segment : drawables.ForegroundLines[lineidx].Segments)
+                for (const auto& token : segment.Tokens)
+                {
+                    if (token.PropertiesIdx == -1 || (token.Type != TokenType::Text && token.Type != TokenType::ElidedText))
+                        continue;
+
+                    const auto& tagprops = drawables.TagDescriptors[token.PropertiesIdx];
+                    if (tagprops.tooltip.empty() && tagprops.link.empty()) continue;
+
+                    auto& region = drawables.InteractiveRegions.emplace_back();
+                    region.Bounds = token.Bounds;
+                    region.Bounds.left += token.Offset.left;
+                    region.Bounds.top += token.Offset.top;
+                    region.Bounds.width -= token.Offset.left;
+                    region.Bounds.height -= token.Offset.top;
+                    region.LineIdx = lineidx;
+                    region.PropertiesIdx = token.PropertiesIdx;
+                }
+
+            std::sort(drawables.InteractiveRegions.begin() + first, drawables.InteractiveRegions.end(),
+                [](const InteractiveRegion& lhs, const InteractiveRegion& rhs) { return lhs.Bounds.left < rhs.Bounds.left; });
+        }
+
+        for (auto depth = 0; depth < IM_RICHTEXT_MAXDEPTH; ++depth)
+            for (auto blockidx = 0; blockidx < (int)drawables.BackgroundBlocks[depth].size(); ++blockidx)
+            {
+                const auto& block = drawables.BackgroundBlocks[depth][blockidx];
+                drawables.BlockIntervals.push_back(BlockInterval{ block.Start.y, block.End.y, 0.f, depth, blockidx });
+            }
+
+        std::sort(drawables.BlockIntervals.begin(), drawables.BlockIntervals.end(),
+            [](const BlockInterval& lhs, const BlockInterval& rhs) { return lhs.top < rhs.top; });
+
+        BuildBlockIntervalTree(drawables.BlockIntervals, 0, (int)drawables.BlockIntervals.size());
+    }
+
+    // Hit-tests the mouse against the layout once per mouse move, and handles hover, tooltips
+    // and hyperlink clicks for the region under the mouse
+    static void HandleInteractions(AnimationData& animation, const Drawables& drawables, ImVec2 pos, 
+        ImVec2 bounds, const RenderConfig& config, TooltipData& tooltip)
+    {
+        auto mousepos = config.Platform->GetCurrentMousePos();
+        auto moved = mousepos.x != animation.lastMouse.x || mousepos.y != animation.lastMouse.y ||
+            pos.x != animation.lastHitPos.x || pos.y != animation.lastHitPos.y;
+
+        if (moved || !drawables.MarqueeLines.empty())
+        {
+            auto inside = mousepos.x >= pos.x && mousepos.y >= pos.y && mousepos.x <= pos.x + bounds.x &&
+                mousepos.y <= pos.y + bounds.y;
+            auto local = mousepos - pos;
+            animation.hoveredRegion = inside ? GetInteractiveRegion(drawables, local, animation) : -1;
+            animation.hoveredBlock = inside ? GetBlockIndex(drawables, local) : std::make_pair(-1, -1);
+            animation.lastMouse = mousepos;
+            animation.lastHitPos = pos;
+        }
+
+        auto hoveringLink = false;
+
+        if (animation.hoveredRegion != -1)
+        {
+            const auto& region = drawables.InteractiveRegions[animation.hoveredRegion];
+            const auto& tagprops = drawables.TagDescriptors[region.PropertiesIdx];
+            tooltip.hovered = region.Bounds;
+            tooltip.hovered.left += pos.x;
+            tooltip.hovered.top += pos.y;
+
+            if (!tagprops.tooltip.empty())
+            {
+                tooltip.pos = mousepos;
+                tooltip.content = tagprops.tooltip;
+            }
+            else
+            {
+                hoveringLink = true;
+                config.Platform->HandleHover(true);
+                if (config.Platform->IsMouseClicked())
+                    config.Platform->HandleHyperlink(tagprops.link);
+            }
+        }
+
+        if (!hoveringLink && animation.linkHovered)
+            config.Platform->HandleHover(false);
+        animation.linkHovered = hoveringLink;
+    }
+
     static void DrawImpl(AnimationData& animation, const Drawables& drawables, ImVec2 pos, ImVec2 bounds, RenderConfig* config)
     {
         using namespace std::chrono;
+        IM_RICHTEXT_PROFILE_SCOPE(Draw, 0);
 
 #if defined(_DEBUG) && defined(IM_RICHTEXT_TARGET_IMGUI)
         ImRichText::ImGuiRenderer overlay{ *config };
@@ -1527,44 +2424,98 @@ namespace ImRichText
         auto endpos = pos + bounds;
         TooltipData tooltip;
 
-        if (animation.xoffsets.empty())
-        {
-            animation.xoffsets.resize(drawables.ForegroundLines.size());
-            std::fill(animation.xoffsets.begin(), animation.xoffsets.end(), 0.f);
-        }
+        if (animation.xoffsets.size() != drawables.MarqueeLines.size())
+            animation.xoffsets.assign(drawables.MarqueeLines.size(), 0.f);
 
         auto currFrameTime = duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+        if (config->TrackDamage) BeginDamageFrame(animation, pos, bounds);
 
         config->Renderer->SetClipRect(pos, endpos);
         config->Renderer->DrawRect(pos, endpos, config->DefaultBgColor, true);
 
-        DrawBackgroundLayer(pos, bounds, drawables.BackgroundBlocks, *config);
-        DrawForegroundLayer(pos, bounds, drawables, *config, tooltip, animation);
+        const auto& mesh = drawables.BackgroundMesh;
+        if (!config->Renderer->SupportsMeshes())
+            DrawBackgroundLayer(pos, bounds, drawables.BackgroundBlocks, AllBlocks, *config);
+        else if (!mesh.empty())
+            config->Renderer->DrawMesh(mesh.positions.data(), mesh.colors.data(), (int)mesh.positions.size(),
+                mesh.indices.data(), (int)mesh.indices.size(), pos);
+
+#ifdef _DEBUG
+        for (auto depth = 0; depth < IM_RICHTEXT_MAXDEPTH; ++depth)
+            for (const auto& block : drawables.BackgroundBlocks[depth])
+                DrawBoundingBox(ContentTypeBg, block.Start + pos, block.End + pos, *config);
+#endif
+
+        if (config->Platform != nullptr)
+            HandleInteractions(animation, drawables, pos, bounds, *config, tooltip);
+
+        DrawForegroundLayer(pos, bounds, drawables, *config, animation);
         config->Renderer->DrawTooltip(tooltip.pos, tooltip.content);
 
+        if (config->TrackDamage && !IsSameBox(tooltip.hovered, animation.hovered))
+        {
+            AddDamage(animation.damage, animation.hovered, pos, bounds);
+            AddDamage(animation.damage, tooltip.hovered, pos, bounds);
+            animation.hovered = tooltip.hovered;
+        }
+
+        // Only documents with animated content advance their state and request new frames
         if (config->Platform != nullptr)
         {
-            if (!config->IsStrictHTML5 && (currFrameTime - animation.lastBlinkTime > IM_RICHTEXT_BLINK_ANIMATION_INTERVAL))
+            auto hasBlink = !config->IsStrictHTML5 && !drawables.BlinkSegments.empty();
+            auto hasMarquee = !drawables.MarqueeLines.empty();
+            animation.nextDeadline = -1;
+
+            if (hasBlink)
             {
-                animation.isVisible = !animation.isVisible;
-                animation.lastBlinkTime = currFrameTime;
-                config->Platform->RequestFrame();
+                if (currFrameTime - animation.lastBlinkTime > IM_RICHTEXT_BLINK_ANIMATION_INTERVAL)
+                {
+                    animation.isVisible = !animation.isVisible;
+                    animation.lastBlinkTime = currFrameTime;
+                    config->Platform->RequestFrame();
+
+                    if (config->TrackDamage)
+                        for (auto [lineidx, segmentidx] : drawables.BlinkSegments)
+                        {
+                            auto box = drawables.ForegroundLines[lineidx].Segments[segmentidx].Bounds;
+                            box.left += pos.x; box.top += pos.y;
+                            animation.pendingDamage.push_back(box);
+                        }
+                }
+
+                animation.nextDeadline = animation.lastBlinkTime + IM_RICHTEXT_BLINK_ANIMATION_INTERVAL;
             }
 
-            if (currFrameTime - animation.lastMarqueeTime > IM_RICHTEXT_MARQUEE_ANIMATION_INTERVAL)
+            if (hasMarquee)
             {
-                for (auto lineidx = 0; lineidx < (int)animation.xoffsets.size(); ++lineidx)
+                if (currFrameTime - animation.lastMarqueeTime > IM_RICHTEXT_MARQUEE_ANIMATION_INTERVAL)
                 {
-                    animation.xoffsets[lineidx] += 1.f;
-                    auto linewidth = drawables.ForegroundLines[lineidx].Content.width;
+                    for (auto idx = 0; idx < (int)animation.xoffsets.size(); ++idx)
+                    {
+                        animation.xoffsets[idx] += 1.f;
+                        auto linewidth = drawables.ForegroundLines[drawables.MarqueeLines[idx]].Content.width;
+
+                        if (animation.xoffsets[idx] >= linewidth)
+                            animation.xoffsets[idx] = -linewidth;
+
+                        if (config->TrackDamage)
+                        {
+                            const auto& line = drawables.ForegroundLines[drawables.MarqueeLines[idx]];
+                            animation.pendingDamage.push_back(BoundedBox{ line.Content.top + pos.y, pos.x, 
+                                bounds.x, line.height() });
+                        }
+                    }
 
-                    if (animation.xoffsets[lineidx] >= linewidth)
-                        animation.xoffsets[lineidx] = -linewidth;
+                    config->Platform->RequestFrame();
+                    animation.lastMarqueeTime = currFrameTime;
                 }
 
-                config->Platform->RequestFrame();
-                animation.lastMarqueeTime = currFrameTime;
+                auto deadline = animation.lastMarqueeTime + IM_RICHTEXT_MARQUEE_ANIMATION_INTERVAL;
+                animation.nextDeadline = animation.nextDeadline == -1 ? deadline : 
+                    std::min(animation.nextDeadline, deadline);
             }
+
+            animation.drawn = true;
         }
 
         config->Renderer->ResetClipRect();
@@ -1580,8 +2531,8 @@ namespace ImRichText
             lhs.range != rhs.range;
     }
 
-    DefaultTagVisitor::DefaultTagVisitor(const RenderConfig& cfg, Drawables& res, ImVec2 bounds)
-        : _bounds{ bounds }, _config{ cfg }, _result{ res }
+    DefaultTagVisitor::DefaultTagVisitor(const RenderConfig& cfg, Drawables& res, ImVec2 bounds, bool measureOnly)
+        : _bounds{ bounds }, _measureOnly{ measureOnly }, _config{ cfg }, _result{ res }
     {
         std::memset(_listItemCountByDepths, 0, IM_RICHTEXT_MAX_LISTDEPTH);
         for (auto idx = 0; idx < IM_RICHTEXT_MAXDEPTH; ++idx) _styleIndexStack[idx] = -2;
@@ -1590,14 +2541,15 @@ namespace ImRichText
         _maxWidth = _bounds.x;
     }
 
-    void DefaultTagVisitor::AddToken(Token token, int propsChanged)
+    void DefaultTagVisitor::AddToken(Token token, int propsChanged, const ImVec2* measured)
     {
         auto& segment = _currLine.Segments.back();
         const auto& style = _result.StyleDescriptors[segment.StyleIdx + 1];
 
         if (token.Type == TokenType::Text)
         {
-            auto sz = _config.Renderer->GetTextSize(token.Content, style.font.font, style.font.size);
+            auto sz = measured != nullptr ? *measured : 
+                _config.Renderer->GetTextSize(token.Content, style.font.font, style.font.size);
             token.VisibleTextSize = (int16_t)token.Content.size();
             token.Bounds.width = sz.x;
             token.Bounds.height = sz.y;
@@ -1616,14 +2568,7 @@ namespace ImRichText
         }
         else if (token.Type == TokenType::ListItemNumbered)
         {
-            if (NumbersAsStr.empty())
-            {
-                NumbersAsStr.reserve(IM_RICHTEXT_MAX_LISTITEM);
-
-                for (auto num = 1; num <= IM_RICHTEXT_MAX_LISTITEM; ++num)
-                    NumbersAsStr.emplace_back(std::to_string(num));
-            }
-
+            const auto& numbers = GetNumbersAsStr();
             auto& listItem = _result.ListItemTokens[token.ListPropsIdx];
             std::memset(listItem.NestedListItemIndex, 0, IM_RICHTEXT_NESTED_ITEMCOUNT_STRSZ);
             auto currbuf = 0;
@@ -1632,7 +2577,7 @@ namespace ImRichText
             {
                 auto itemcount = _listItemCountByDepths[depth] - 1;
                 auto itemlen = itemcount > 99 ? 3 : itemcount > 9 ? 2 : 1;
-                std::memcpy(listItem.NestedListItemIndex + currbuf, NumbersAsStr[itemcount].data(), itemlen);
+                std::memcpy(listItem.NestedListItemIndex + currbuf, numbers[itemcount].data(), itemlen);
                 currbuf += itemlen;
 
                 listItem.NestedListItemIndex[currbuf] = '.';
@@ -1683,15 +2628,40 @@ namespace ImRichText
         return segment;
     }
 
-    void DefaultTagVisitor::GenerateTextToken(std::string_view content)
+    void DefaultTagVisitor::GenerateTextToken(std::string_view content, const ImVec2* measured)
     {
         Token token;
         token.Content = content;
-        AddToken(token, NoStyleChange);
+        token.PropertiesIdx = _currentStackPos >= 0 ? _tagStack[_currentStackPos].tagPropIdx : (int16_t)-1;
+        AddToken(token, NoStyleChange, measured);
+    }
+
+    void DefaultTagVisitor::AddLineBreak()
+    {
+        _result.ForegroundLines.push_back(_currLine);
+        _currLine = CreateNewLine(-1);
+        AddSegment();
+        _currLine.Segments.back().StyleIdx = _currStyleIdx;
+    }
+
+    void DefaultTagVisitor::RecordEvent(LayoutTape::EventType type, std::string_view text,
+        std::optional<std::string_view> value, bool selfTerminating)
+    {
+        if (_tape == nullptr) return;
+
+        auto& event = _tape->events.emplace_back();
+        event.type = type;
+        event.text = text;
+        event.value = value;
+        event.selfTerminating = selfTerminating;
+        event.firstWord = (int)_tape->words.size();
     }
 
     std::vector<DefaultTagVisitor::TokenPositionRemapping> DefaultTagVisitor::PerformWordWrap(int index)
     {
+        IM_RICHTEXT_PROFILE_SCOPE(WordWrap, 0);
+        IM_RICHTEXT_PROFILE_LINE(index);
+
         // Word wrapping happens through the registered text shaper in _config member
         // Since a single line can now map to multiple lines, we record the mappings 
         // of original (line, segment, token) triplet to newer triplets in the broken
@@ -1909,12 +2879,18 @@ namespace ImRichText
 
     void DefaultTagVisitor::UpdateLineGeometry(const std::pair<int, int>& linesModified, int depth)
     {
+        IM_RICHTEXT_PROFILE_SCOPE(Geometry, 0);
         auto& result = _result.ForegroundLines;
 
         if (_currHasBgBlock)
             RecordBackgroundSpanEnd(true, false, depth, true);
 
-        for (auto lineIdx = 0; lineIdx < (linesModified.first + linesModified.second); ++lineIdx)
+        // Background blocks only apply to their lines once their span has ended, hence lines of
+        // the spans which ended since the last update are recomputed along with the modified ones
+        auto firstLine = _dirtyLine == -1 ? linesModified.first : std::min(_dirtyLine, linesModified.first);
+        _dirtyLine = -1;
+
+        for (auto lineIdx = firstLine; lineIdx < (linesModified.first + linesModified.second); ++lineIdx)
         {
             auto segmentIdx = 0;
             auto& line = result[lineIdx];
@@ -1999,6 +2975,8 @@ namespace ImRichText
 
     void DefaultTagVisitor::RecordBackgroundSpanEnd(bool lineAdded, bool segmentAdded, int depth, bool includeChildren)
     {
+        auto markDirty = [this](int lineIdx) { _dirtyLine = _dirtyLine == -1 ? lineIdx : std::min(_dirtyLine, lineIdx); };
+
         if (includeChildren)
         {
             for (auto childDepth = depth; childDepth < IM_RICHTEXT_MAXDEPTH; ++childDepth)
@@ -2013,6 +2991,7 @@ namespace ImRichText
                         block.span.end.second = lineAdded ?
                             std::max(0, (int)_result.ForegroundLines.back().Segments.size() - (segmentAdded ? 2 : 1)) :
                             std::max(0, (int)_currLine.Segments.size() - (segmentAdded ? 2 : 1));
+                        markDirty(block.span.start.first);
                     }
                 }
             }
@@ -2028,6 +3007,7 @@ namespace ImRichText
                 block.span.end.second = lineAdded ?
                     std::max(0, (int)_result.ForegroundLines.back().Segments.size() - (segmentAdded ? 2 : 1)) :
                     std::max(0, (int)_currLine.Segments.size() - (segmentAdded ? 2 : 1));
+                markDirty(block.span.start.first);
             }
         }
     }
@@ -2079,6 +3059,7 @@ namespace ImRichText
         newline.Content.left = ((float)(_currListDepth + 1) * _config.ListItemIndent) +
             ((float)(_currBlockquoteDepth + 1) * _config.BlockquoteOffset);
         newline.Content.top = lastline.Content.top + lastline.height() + (isEmpty ? 0.f : _config.LineGap);
+        if (_measureOnly) ReleaseMeasuredLines();
         return newline;
     }
 
@@ -2225,6 +3206,7 @@ namespace ImRichText
 
     bool DefaultTagVisitor::TagStart(std::string_view tag)
     {
+        RecordEvent(LayoutTape::EventType::TagStart, tag);
         if (!CanContentBeMultiline(_currTagType) && AreSame(tag, "br")) return true;
         if (_pendingBgBlockCreation) RecordBackgroundSpanStart();
         _prevTagType = _currTagType;
@@ -2248,6 +3230,7 @@ namespace ImRichText
         
     bool DefaultTagVisitor::Attribute(std::string_view name, std::optional<std::string_view> value)
     {
+        RecordEvent(LayoutTape::EventType::Attribute, name, value);
         LOG("Reading attribute: %.*s\n", (int)name.size(), name.data());
         auto propsSpecified = 0;
         auto nonStyleAttribute = false;
@@ -2263,6 +3246,7 @@ namespace ImRichText
 
     bool DefaultTagVisitor::TagStartDone()
     {
+        RecordEvent(LayoutTape::EventType::TagStartDone);
         auto hasSegments = !_currLine.Segments.empty();
         auto hasUniqueStyle = CreateNewStyle();
         auto& currentStyle = Style(_currentStackPos);
@@ -2275,6 +3259,10 @@ namespace ImRichText
             _result.TagDescriptors.emplace_back(_currTagProps);
         }
 
+        // Text inside nested tags i.e. <a><b>text</b></a> still belongs to the link/tooltip
+        _tagStack[_currentStackPos].tagPropIdx = tagPropIdx != -1 ? tagPropIdx :
+            _currentStackPos > 0 ? _tagStack[_currentStackPos - 1].tagPropIdx : (int16_t)-1;
+
         if (_currTagType == TagType::List)
         {
             _currListDepth++;
@@ -2350,23 +3338,8 @@ namespace ImRichText
         return true;
     }
 
-    bool DefaultTagVisitor::Content(std::string_view content)
+    void DefaultTagVisitor::BeginContent()
     {
-        struct UserData
-        {
-            StyleDescriptor& currentStyle;
-            DrawableLine& currline;
-            std::vector<DrawableLine>& newlines;
-            std::string_view content;
-            int styleIdx;
-            DefaultTagVisitor* self;
-        };
-
-        // Ignore newlines, tabs & consecutive spaces
-        auto to = 0, from = 0;
-        auto& currentStyle = Style(_currentStackPos);
-        LOG("Processing content [%.*s]\n", (int)content.size(), content.data());
-
         // If last processed entry was tag end, then this is a continuation of
         // text content of the parent tag of last tag. Hence, if style differs,
         // create a new segment (or if current line is empty)
@@ -2376,34 +3349,75 @@ namespace ImRichText
             AddSegment();
 
         if (_pendingBgBlockCreation) RecordBackgroundSpanStart();
+    }
+
+    bool DefaultTagVisitor::Content(std::string_view content)
+    {
+        // Ignore newlines, tabs & consecutive spaces
+        LOG("Processing content [%.*s]\n", (int)content.size(), content.data());
+        BeginContent();
+        RecordEvent(LayoutTape::EventType::Content, content);
 
-        auto curridx = 0, start = 0;
         auto ignoreLineBreaks = _currSuperscriptLevel > 0 || _currSubscriptLevel > 0;
         auto isPreformatted = IsPreformattedContent(_currTag);
-        UserData userdata{ currentStyle, _currLine, _result.ForegroundLines, content, _currStyleIdx, this };
+        IM_RICHTEXT_PROFILE_SCOPE(Segmentation, content.size());
 
         _config.TextShaper->SegmentText(content, _currStyle.wscbhv, 
             [](int, void* userdata)
             {
-                const auto& data = *reinterpret_cast<UserData*>(userdata);
-                data.newlines.push_back(data.currline);
-
-                data.currline = CreateNewLine(-1);
-                data.self->AddSegment();
-                data.currline.Segments.back().StyleIdx = data.styleIdx;
+                auto self = reinterpret_cast<DefaultTagVisitor*>(userdata);
+                if (self->_tape != nullptr) self->_tape->words.emplace_back();
+                self->AddLineBreak();
             }, 
             [](int, std::string_view word, ImVec2 dim, void* userdata)
             {
-                const auto& data = *reinterpret_cast<UserData*>(userdata);
-                data.self->GenerateTextToken(word);
+                auto self = reinterpret_cast<DefaultTagVisitor*>(userdata);
+                if (self->_tape != nullptr) self->_tape->words.push_back(word);
+                self->GenerateTextToken(word);
             }, 
-            _config, ignoreLineBreaks, isPreformatted, &userdata);
+            _config, ignoreLineBreaks, isPreformatted, this);
+
+        if (_tape != nullptr)
+            _tape->events.back().wordCount = (int)_tape->words.size() - _tape->events.back().firstWord;
+        _lastOp = Operation::Content;
+        return true;
+    }
+
+    // Segmentation is already recorded, hence consecutive words (which share the style) are
+    // measured in one batch
+    bool DefaultTagVisitor::ReplayContent(std::string_view content, const std::string_view* words, int count)
+    {
+        LOG("Replaying content [%.*s]\n", (int)content.size(), content.data());
+        BeginContent();
+
+        for (auto from = 0; from < count;)
+        {
+            if (words[from].data() == nullptr)
+            {
+                AddLineBreak();
+                ++from;
+                continue;
+            }
+
+            auto to = from;
+            while (to < count && words[to].data() != nullptr) ++to;
+
+            const auto& style = _result.StyleDescriptors[_currLine.Segments.back().StyleIdx + 1];
+            _measured.resize((std::size_t)(to - from));
+            _config.Renderer->GetTextSizes(words + from, to - from, style.font.font, style.font.size, _measured.data());
+
+            for (auto idx = from; idx < to; ++idx)
+                GenerateTextToken(words[idx], &_measured[idx - from]);
+            from = to;
+        }
+
         _lastOp = Operation::Content;
         return true;
     }
 
     bool DefaultTagVisitor::TagEnd(std::string_view tag, bool selfTerminatingTag)
     {
+        RecordEvent(LayoutTape::EventType::TagEnd, tag, std::nullopt, selfTerminatingTag);
         if (!CanContentBeMultiline(_currTagType) && AreSame(tag, "br")) return true;
 
         // pop style properties and reset
@@ -2444,6 +3458,7 @@ namespace ImRichText
                 StyleDescriptor style = _currStyle;
                 style.height = 1.f;
                 style.fgcolor = _config.HeaderLineColor;
+                style.fgslot = PaletteSlot::HeaderLine;
                 _result.StyleDescriptors.emplace_back(style);
                 AddSegment().StyleIdx = (int)_result.StyleDescriptors.size() - 2;
 
@@ -2527,9 +3542,52 @@ namespace ImRichText
     {
         MoveToNextLine(false, 0);
         _maxWidth = std::max(_maxWidth, _result.ForegroundLines.back().Content.width);
+        FinalizeLines(true);
+        if (_tape != nullptr) _tape->complete = true;
+    }
+
+    bool DefaultTagVisitor::ShouldSuspend() const
+    {
+        return (_suspendHeight >= 0.f && LaidOutHeight() >= _suspendHeight) ||
+            (_suspendTime != std::chrono::steady_clock::time_point::max() && 
+                std::chrono::steady_clock::now() >= _suspendTime);
+    }
+
+    float DefaultTagVisitor::LaidOutHeight() const
+    {
+        if (_result.ForegroundLines.empty()) return 0.f;
+        const auto& line = _result.ForegroundLines.back();
+        return line.Content.top + line.height();
+    }
+
+    // Lines which are already added are not modified by further layout, except the lines of 
+    // background blocks which have not ended yet (or whose geometry was not updated since they
+    // ended). Hence alignment and backgrounds are computed for the lines before the first such
+    // block. Background blocks are generated in order, upto the first one which has not ended 
+    // yet or ends past the finalized lines, unless the layout is complete.
+    void DefaultTagVisitor::FinalizeLines(bool complete)
+    {
+        IM_RICHTEXT_PROFILE_SCOPE(Finalize, 0);
+        auto firstLine = _finalizedLines;
+        auto lastLine = (int)_result.ForegroundLines.size();
+        int firstBlocks[IM_RICHTEXT_MAXDEPTH];
+        for (auto depth = 0; depth < IM_RICHTEXT_MAXDEPTH; ++depth)
+            firstBlocks[depth] = (int)_result.BackgroundBlocks[depth].size();
+
+        if (!complete)
+        {
+            if (_dirtyLine != -1) lastLine = std::min(lastLine, _dirtyLine);
+
+            for (auto depth = 0; depth < IM_RICHTEXT_MAXDEPTH; ++depth)
+                for (auto bidx = _finalizedBlocks[depth]; bidx < (int)_backgroundBlocks[depth].size(); ++bidx)
+                    if (_backgroundBlocks[depth][bidx].span.end.first == -1)
+                        lastLine = std::min(lastLine, _backgroundBlocks[depth][bidx].span.start.first);
+
+            if (lastLine <= firstLine) return;
+        }
 
         // Default aligment of segments is left horizontally and centered vertically in the current line
-        for (auto index = 0; index < (int)_result.ForegroundLines.size(); ++index)
+        for (auto index = firstLine; index < lastLine; ++index)
         {
             auto& line = _result.ForegroundLines[index];
 
@@ -2542,8 +3600,9 @@ namespace ImRichText
         }
 
         // Apply alignment to geometry
-        for (auto& line : _result.ForegroundLines)
+        for (auto index = firstLine; index < lastLine; ++index)
         {
+            auto& line = _result.ForegroundLines[index];
             if (line.Marquee) line.Content.width = _maxWidth;
 
             for (auto& segment : line.Segments)
@@ -2636,9 +3695,17 @@ namespace ImRichText
             //    https://jsfiddle.net/9zrLyo6s/ for the reference behavior)
             // 3. Backgrounds that are limited to one line and did not split after text layout,
             //    This is the simplest case, generate simple geometry.
-            for (const auto& block : _backgroundBlocks[depth])
+            for (; _finalizedBlocks[depth] < (int)_backgroundBlocks[depth].size(); ++_finalizedBlocks[depth])
             {
-                if (block.span.end.first == -1) continue;
+                const auto& block = _backgroundBlocks[depth][_finalizedBlocks[depth]];
+
+                if (block.span.end.first == -1)
+                {
+                    if (complete) continue;
+                    break;
+                }
+
+                if (block.span.end.first >= lastLine) break;
 
                 auto startBounds = block.span.start.second == -1 ? _result.ForegroundLines[block.span.start.first].Content :
                     _result.ForegroundLines[block.span.start.first].Segments[block.span.start.second].Bounds;
@@ -2722,6 +3789,40 @@ namespace ImRichText
                 }
             }
         }
+
+        _finalizedLines = lastLine;
+
+        // Measurement only requires the geometry of lines and background blocks
+        if (_measureOnly) return;
+
+        AppendBackgroundMesh(_result, firstBlocks, _config);
+        RecordAnimatedContent(_result, firstLine, lastLine);
+        CreateHitTestIndex(_result, firstLine, lastLine);
+    }
+
+    // Measurement only requires the extents of lines and background blocks, hence the segments
+    // and tokens of finalized lines are released, unless background blocks yet to be generated
+    // refer to them. The last line is retained, as closing tags still extend it. Horizontal 
+    // alignment depends on the width of the widest line, hence lines can only be finalized early
+    // if the width is specified (as with lazy layout).
+    void DefaultTagVisitor::ReleaseMeasuredLines()
+    {
+        auto& lines = _result.ForegroundLines;
+        if (_bounds.x <= 0.f || _bounds.x == FLT_MAX || (int)lines.size() < _nextRelease) return;
+
+        FinalizeLines(false);
+        auto keepFrom = std::min(_finalizedLines, (int)lines.size() - 1);
+
+        for (auto depth = 0; depth < IM_RICHTEXT_MAXDEPTH; ++depth)
+            for (auto bidx = _finalizedBlocks[depth]; bidx < (int)_backgroundBlocks[depth].size(); ++bidx)
+                keepFrom = std::min(keepFrom, _backgroundBlocks[depth][bidx].span.start.first);
+
+        for (; _releasedLines < keepFrom; ++_releasedLines)
+            std::vector<SegmentData>{}.swap(lines[_releasedLines].Segments);
+
+        // Check again once as many lines are added as are retained now, so that a block which
+        // stays open (e.g. a container of the whole text) does not cost a scan per line
+        _nextRelease = (int)lines.size() + std::max(32, (int)lines.size() - _releasedLines);
     }
 
     void DefaultTagVisitor::Error(std::string_view tag)
@@ -2743,15 +3844,108 @@ namespace ImRichText
     // Section #4. Implementation of public API
     // ===============================================================
 
+    // Hashes every member which affects either layout or the drawables it produces, the 
+    // result is cached in the config until it is reset to 0
+    static std::size_t GetConfigFingerprint(RenderConfig& config)
+    {
+        if (config.Fingerprint != 0) return config.Fingerprint;
+
+        std::size_t hash = 0;
+        HashCombine(hash, static_cast<const void*>(config.Renderer));
+        HashCombine(hash, static_cast<int>(config.ShadowQuality));
+        HashCombine(hash, reinterpret_cast<const void*>(config.NamedColor));
+        HashCombine(hash, static_cast<const void*>(config.TextShaper));
+        HashCombine(hash, static_cast<const void*>(config.UserData));
+        HashCombine(hash, config.Scale);
+        HashCombine(hash, config.FontScale);
+        HashCombine(hash, config.TagStart);
+        HashCombine(hash, config.TagEnd);
+        HashCombine(hash, config.EscapeSeqStart);
+        HashCombine(hash, config.EscapeSeqEnd);
+        HashCombine(hash, config.LineGap);
+        HashCombine(hash, config.WordWrap);
+        HashCombine(hash, config.LazyLayout);
+        HashCombine(hash, config.ParagraphStop);
+        HashCombine(hash, config.TabStop);
+        HashCombine(hash, config.ListItemIndent);
+        HashCombine(hash, config.ListItemOffset);
+        HashCombine(hash, static_cast<int>(config.ListItemBullet));
+        HashCombine(hash, config.DefaultFontFamily);
+        HashCombine(hash, config.DefaultFontSize);
+        for (auto sz : config.HFontSizes) HashCombine(hash, sz);
+        HashCombine(hash, config.BlockquotePadding);
+        HashCombine(hash, config.BlockquoteOffset);
+        HashCombine(hash, config.BlockquoteBarWidth);
+        HashCombine(hash, config.MeterDefaultSize.x);
+        HashCombine(hash, config.MeterDefaultSize.y);
+        HashCombine(hash, config.CodeBlockPadding);
+        HashCombine(hash, config.BulletSizeScale);
+        HashCombine(hash, config.ScaleSuperscript);
+        HashCombine(hash, config.ScaleSubscript);
+        HashCombine(hash, config.HrVerticalMargins);
+        HashCombine(hash, config.IsStrictHTML5);
+
+        config.Fingerprint = hash != 0 ? hash : 1u;
+        return config.Fingerprint;
+    }
+
+    static void ComputeHeaderFontSizes(RenderConfig& config)
+    {
+        config.HFontSizes[0] = config.DefaultFontSize * 2.f;
+        config.HFontSizes[1] = config.DefaultFontSize * 1.5f;
+        config.HFontSizes[2] = config.DefaultFontSize * 1.17f;
+        config.HFontSizes[3] = config.DefaultFontSize;
+        config.HFontSizes[4] = config.DefaultFontSize * 0.83f;
+        config.HFontSizes[5] = config.DefaultFontSize * 0.67f;
+    }
+
+    RenderConfigHandle CreateConfig(const RenderConfig& config)
+    {
+        auto created = std::make_shared<RenderConfig>(config);
+        ComputeHeaderFontSizes(*created);
+        created->Fingerprint = 0;
+        GetConfigFingerprint(*created);
+        return created;
+    }
+
+    template <typename ContextT>
+    static ConfigStack& GetConfigStack(std::unordered_map<ContextT*, ConfigStack>& configs,
+        ConfigStackCache<ContextT>& cache, std::size_t owner, ContextT* ctx)
+    {
+        if (cache.stack == nullptr || cache.owner != owner || cache.context != ctx)
+        {
+            cache.stack = &configs[ctx];
+            cache.owner = owner;
+            cache.context = ctx;
+        }
+
+        return *cache.stack;
+    }
+
+    // Internals only read the pushed configs, apart from the fingerprint which is computed on push
+    static RenderConfig* GetTopConfig(const ConfigStack& stack)
+    {
+        assert(!stack.empty());
+        return const_cast<RenderConfig*>(stack.back().get());
+    }
+
+    // The returned config may be modified by the caller, hence a config still shared with a 
+    // handle is replaced by a private copy first
+    static RenderConfig* GetMutableConfig(RenderConfigHandle& config)
+    {
+        if (config.use_count() > 1) config = std::make_shared<RenderConfig>(*config);
+        auto result = const_cast<RenderConfig*>(config.get());
+        result->Fingerprint = 0;
+        return result;
+    }
+
 #ifdef IM_RICHTEXT_TARGET_IMGUI
     static RenderConfig* GetRenderConfig(RenderConfig* config = nullptr)
     {
         if (config == nullptr)
         {
-            auto ctx = ImGui::GetCurrentContext();
-            auto it = ImRenderConfigs.find(ctx);
-            assert(it != ImRenderConfigs.end());
-            config = &(it->second.back());
+            auto& g = GetContext();
+            config = GetTopConfig(GetConfigStack(g.ImRenderConfigs, ImCurrentConfigs, g.Id, ImGui::GetCurrentContext()));
         }
 
         return config;
@@ -2761,9 +3955,8 @@ namespace ImRichText
     static RenderConfig* GetRenderConfig(BLContext& ctx, RenderConfig* config = nullptr)
     {
         if (config != nullptr) return config;
-        auto it = BLRenderConfigs.find(&ctx);
-        assert(it != BLRenderConfigs.end());
-        return &(it->second.back());
+        auto& g = GetContext();
+        return GetTopConfig(GetConfigStack(g.BLRenderConfigs, BLCurrentConfigs, g.Id, &ctx));
     }
 #endif
 
@@ -2771,7 +3964,7 @@ namespace ImRichText
     static void Draw(std::size_t richTextId, const Drawables& drawables, ImVec2 pos, ImVec2 bounds, RenderConfig* config)
     {
         config = GetRenderConfig(config);
-        auto& animation = RichTextMap.at(richTextId).animationData;
+        auto& animation = FindRichText(richTextId)->animationData;
         DrawImpl(animation, drawables, pos, bounds, config);
     }
 
@@ -2792,29 +3985,29 @@ namespace ImRichText
 
     RenderConfig* GetCurrentConfig()
     {
-        auto ctx = ImGui::GetCurrentContext();
-        auto it = ImRenderConfigs.find(ctx);
-        return it != ImRenderConfigs.end() ? &(it->second.back()) : &(ImRenderConfigs.at(nullptr).front());
+        auto& g = GetContext();
+        auto& stack = GetConfigStack(g.ImRenderConfigs, ImCurrentConfigs, g.Id, ImGui::GetCurrentContext());
+        return GetMutableConfig(!stack.empty() ? stack.back() : g.ImRenderConfigs.at(nullptr).front());
     }
 
     void PushConfig(RenderConfig& config)
     {
-        config.HFontSizes[0] = config.DefaultFontSize * 2.f;
-        config.HFontSizes[1] = config.DefaultFontSize * 1.5f;
-        config.HFontSizes[2] = config.DefaultFontSize * 1.17f;
-        config.HFontSizes[3] = config.DefaultFontSize;
-        config.HFontSizes[4] = config.DefaultFontSize * 0.83f;
-        config.HFontSizes[5] = config.DefaultFontSize * 0.67f;
+        ComputeHeaderFontSizes(config);
+        PushConfig(CreateConfig(config));
+    }
 
-        auto ctx = ImGui::GetCurrentContext();
-        ImRenderConfigs[ctx].push_back(config);
+    void PushConfig(const RenderConfigHandle& config)
+    {
+        auto& g = GetContext();
+        assert(config != nullptr);
+        GetConfigStack(g.ImRenderConfigs, ImCurrentConfigs, g.Id, ImGui::GetCurrentContext()).push_back(config);
     }
 
     void PopConfig()
     {
-        auto ctx = ImGui::GetCurrentContext();
-        auto it = ImRenderConfigs.find(ctx);
-        if (it != ImRenderConfigs.end()) it->second.pop_back();
+        auto& g = GetContext();
+        auto& stack = GetConfigStack(g.ImRenderConfigs, ImCurrentConfigs, g.Id, ImGui::GetCurrentContext());
+        if (!stack.empty()) stack.pop_back();
     }
 
 #endif
@@ -2823,61 +4016,96 @@ namespace ImRichText
         ImVec2 pos, ImVec2 bounds, RenderConfig* config)
     {
         config = GetRenderConfig(context, config);
-        auto& animation = RichTextMap.at(richTextId).animationData;
+        auto& animation = FindRichText(richTextId)->animationData;
         DrawImpl(animation, drawables, pos, bounds, config);
     }
 
     bool ShowDrawables(BLContext& context, ImVec2 pos, std::size_t richTextId, Drawables& drawables,
         ImVec2 bounds, RenderConfig* config)
     {
-        Draw(context, richTextId, drawables, pos + style.FramePadding, bounds, config);
+        Draw(context, richTextId, drawables, pos, bounds, config);
         return true;
     }
 
     RenderConfig* GetCurrentConfig(BLContext& context)
     {
-        auto it = BLRenderConfigs.find(&context);
-        return it != BLRenderConfigs.end() ? &(it->second.back()) : &(BLRenderConfigs.at(nullptr).front());
+        auto& g = GetContext();
+        auto& stack = GetConfigStack(g.BLRenderConfigs, BLCurrentConfigs, g.Id, &context);
+        return GetMutableConfig(!stack.empty() ? stack.back() : g.BLRenderConfigs.at(nullptr).front());
     }
 
     void PushConfig(RenderConfig& config, BLContext& context)
     {
-        config.HFontSizes[0] = config.DefaultFontSize * 2.f;
-        config.HFontSizes[1] = config.DefaultFontSize * 1.5f;
-        config.HFontSizes[2] = config.DefaultFontSize * 1.17f;
-        config.HFontSizes[3] = config.DefaultFontSize;
-        config.HFontSizes[4] = config.DefaultFontSize * 0.83f;
-        config.HFontSizes[5] = config.DefaultFontSize * 0.67f;
+        ComputeHeaderFontSizes(config);
+        PushConfig(CreateConfig(config), context);
+    }
 
-        BLRenderConfigs[&context].push_back(config);
+    void PushConfig(const RenderConfigHandle& config, BLContext& context)
+    {
+        auto& g = GetContext();
+        assert(config != nullptr);
+        GetConfigStack(g.BLRenderConfigs, BLCurrentConfigs, g.Id, &context).push_back(config);
     }
 
     void PopConfig(BLContext& context)
     {
-        auto it = BLRenderConfigs.find(&context);
-        if (it != BLRenderConfigs.end()) it->second.pop_back();
+        auto& g = GetContext();
+        auto& stack = GetConfigStack(g.BLRenderConfigs, BLCurrentConfigs, g.Id, &context);
+        if (!stack.empty()) stack.pop_back();
     }
-#endif
 
-    RenderConfig* GetDefaultConfig(const DefaultConfigParams& params)
+    static bool HasAnimations(const Drawables& drawables)
     {
-        auto config = &(ImRenderConfigs[nullptr].emplace_back());
-        config->NamedColor = &GetColor;
-        config->FontScale = params.FontScale;
-        config->DefaultFontSize = params.DefaultFontSize;
-        config->MeterDefaultSize = { params.DefaultFontSize * 5.0f, params.DefaultFontSize };
-        config->TextShaper = CreateTextShaper(params.Charset);
-        config->HFontSizes[0] = params.DefaultFontSize * 2.f;
-        config->HFontSizes[1] = params.DefaultFontSize * 1.5f;
-        config->HFontSizes[2] = params.DefaultFontSize * 1.17f;
-        config->HFontSizes[3] = params.DefaultFontSize;
-        config->HFontSizes[4] = params.DefaultFontSize * 0.83f;
-        config->HFontSizes[5] = params.DefaultFontSize * 0.67f;
+        return !drawables.MarqueeLines.empty() || !drawables.BlinkSegments.empty();
+    }
 
-#ifdef IM_RICHTEXT_BUNDLED_FONTLOADER
-        if (params.FontLoadFlags != 0) LoadDefaultFonts(*config, params.FontLoadFlags, params.Charset);
+    // Renders the drawables into an offscreen image, which is blitted on subsequent frames
+    // until the layout changes. The layer context can use worker threads, as the whole
+    // document is submitted at once and then flushed.
+    static bool RenderLayer(RichTextData& data, RenderConfig* config)
+    {
+        auto width = (int)std::ceil(data.computedBounds.x);
+        auto height = (int)std::ceil(data.computedBounds.y);
+        if (width <= 0 || height <= 0) return false;
+
+        if (data.layer.create(width, height, BL_FORMAT_PRGB32) != BL_SUCCESS)
+            return false;
+
+        BLContextCreateInfo info{};
+        info.threadCount = config->RenderThreadCount;
+
+        BLContext layerContext{ data.layer, info };
+        layerContext.clearAll();
+
+        Blend2DRenderer renderer{ layerContext };
+        RenderConfig layerConfig = *config;
+        layerConfig.Renderer = &renderer;
+        layerConfig.Platform = nullptr;
+
+        AnimationData animation;
+        DrawImpl(animation, GetLayout(data), ImVec2{ 0.f, 0.f }, data.computedBounds, &layerConfig);
+        layerContext.end();
+        data.layerValid = true;
+        return true;
+    }
 #endif
-        return config;
+
+    RenderConfig* GetDefaultConfig(const DefaultConfigParams& params)
+    {
+        auto& g = GetContext();
+        auto config = std::make_shared<RenderConfig>();
+        g.ImRenderConfigs[nullptr].push_back(config);
+        config->NamedColor = &GetColor;
+        config->FontScale = params.FontScale;
+        config->DefaultFontSize = params.DefaultFontSize;
+        config->MeterDefaultSize = { params.DefaultFontSize * 5.0f, params.DefaultFontSize };
+        config->TextShaper = CreateTextShaper(params.Charset);
+        ComputeHeaderFontSizes(*config);
+
+#ifdef IM_RICHTEXT_BUNDLED_FONTLOADER
+        if (params.FontLoadFlags != 0) LoadDefaultFonts(*config, params.FontLoadFlags, params.Charset);
+#endif
+        return config.get();
     }
 
     ITextShaper* CreateTextShaper(TextContentCharset charset)
@@ -2891,18 +4119,245 @@ namespace ImRichText
         return nullptr;
     }
 
-    static Drawables GetDrawables(const char* text, const char* textend, const RenderConfig& config, ImVec2 bounds)
+    // Lazily laid out documents keep their parser and visitor state between frames
+    template <typename T>
+    static void AddContainerStats(RichTextMemoryStats& stats, ContainerStats& entry, const std::vector<T>& container)
+    {
+        entry.count += container.size();
+        entry.bytes += container.capacity() * sizeof(T);
+        entry.slack += (container.capacity() - container.size()) * sizeof(T);
+        stats.total += container.capacity() * sizeof(T);
+    }
+
+    static void AddLayoutStats(RichTextMemoryStats& stats, const Drawables& drawables)
+    {
+        AddContainerStats(stats, stats.lines, drawables.ForegroundLines);
+        AddContainerStats(stats, stats.styles, drawables.StyleDescriptors);
+        AddContainerStats(stats, stats.tagDescriptors, drawables.TagDescriptors);
+        AddContainerStats(stats, stats.listItems, drawables.ListItemTokens);
+        AddContainerStats(stats, stats.backgroundMesh, drawables.BackgroundMesh.positions);
+        AddContainerStats(stats, stats.backgroundMesh, drawables.BackgroundMesh.colors);
+        AddContainerStats(stats, stats.backgroundMesh, drawables.BackgroundMesh.indices);
+        AddContainerStats(stats, stats.indices, drawables.MarqueeLines);
+        AddContainerStats(stats, stats.indices, drawables.BlinkSegments);
+        AddContainerStats(stats, stats.indices, drawables.InteractiveRegions);
+        AddContainerStats(stats, stats.indices, drawables.BlockIntervals);
+
+        for (const auto& line : drawables.ForegroundLines)
+        {
+            AddContainerStats(stats, stats.segments, line.Segments);
+            for (const auto& segment : line.Segments)
+                AddContainerStats(stats, stats.tokens, segment.Tokens);
+        }
+
+        for (auto depth = 0; depth < IM_RICHTEXT_MAXDEPTH; ++depth)
+            AddContainerStats(stats, stats.backgroundBlocks[depth], drawables.BackgroundBlocks[depth]);
+    }
+
+    static void AddTapeStats(RichTextMemoryStats& stats, const LayoutTape& tape)
+    {
+        AddContainerStats(stats, stats.tape, tape.events);
+        AddContainerStats(stats, stats.tape, tape.words);
+    }
+
+    static std::size_t EstimateLayoutMemory(const Drawables& drawables)
+    {
+        RichTextMemoryStats stats;
+        AddLayoutStats(stats, drawables);
+        return stats.total;
+    }
+
+    // Shared layouts are accounted by themselves, see GetSharedLayout. The tape is accounted
+    // with the layout, as it is dropped along with it.
+    static void UpdateLayoutMemory(RichTextData& data)
+    {
+        auto& g = GetContext();
+        RichTextMemoryStats tape;
+        AddTapeStats(tape, data.tape);
+        auto bytes = tape.total + (data.sharedLayout ? 0u : EstimateLayoutMemory(data.drawables));
+        g.LayoutStats.bytes = g.LayoutStats.bytes - data.layoutBytes + bytes;
+        data.layoutBytes = bytes;
+    }
+
+    // Layout jobs keep a copy of the config, as an equivalent config (i.e. with the same fingerprint) 
+    // might be used on later frames, and the original popped
+    struct LayoutJob
+    {
+        ParserState state;
+        RenderConfig config;
+        Drawables staged; // Time budgeted layout is built here, and replaces the displayed one once complete
+        DefaultTagVisitor visitor;
+        const LayoutTape* replay = nullptr; // Replayed instead of parsing the text, if set
+        bool isStaged = false;
+
+        LayoutJob(const RenderConfig& cfg, Drawables* result, ImVec2 bounds, LayoutTape* tape)
+            : config{ cfg }, visitor{ config, result != nullptr ? *result : staged, bounds }, 
+            isStaged{ result == nullptr } 
+        {
+            if (tape != nullptr && tape->complete) replay = tape;
+            else visitor.RecordTape(tape);
+        }
+    };
+
+    Context::~Context()
+    {
+        // Shared layouts unregister themselves from the context once released
+        LayoutJobs.clear();
+        RichTextSlots.clear();
+#ifdef IM_RICHTEXT_BUNDLED_FONTLOADER
+        DestroyFontContext(Fonts);
+#endif
+    }
+
+    Context* CreateContext()
+    {
+        auto context = new Context{};
+#ifdef IM_RICHTEXT_BUNDLED_FONTLOADER
+        context->Fonts = CreateFontContext();
+#endif
+        return context;
+    }
+
+    void DestroyContext(Context* context)
     {
+        if (context == nullptr) context = CurrentContext;
+        if (context == nullptr || context == &DefaultContext) return;
+        if (context == CurrentContext) SetCurrentContext(nullptr);
+        delete context;
+    }
+
+    void SetCurrentContext(Context* context)
+    {
+        CurrentContext = context != &DefaultContext ? context : nullptr;
+#ifdef IM_RICHTEXT_BUNDLED_FONTLOADER
+        SetCurrentFontContext(CurrentContext != nullptr ? CurrentContext->Fonts : nullptr);
+#endif
+    }
+
+    Context* GetCurrentContext()
+    {
+        return &GetContext();
+    }
+
+    // Members of the config which affect parsing and segmentation of text
+    static std::size_t GetSegmentationKey(const RenderConfig& config)
+    {
+        std::size_t hash = 0;
+        HashCombine(hash, static_cast<const void*>(config.TextShaper));
+        HashCombine(hash, config.TagStart);
+        HashCombine(hash, config.TagEnd);
+        HashCombine(hash, config.EscapeSeqStart);
+        HashCombine(hash, config.EscapeSeqEnd);
+        return hash;
+    }
+
+    // Returns the tape to replay (if complete and recorded with an equivalent config) or to 
+    // record into, if segmentation is cached for the text
+    static LayoutTape* PrepareLayoutTape(RichTextData& data, const RenderConfig& config)
+    {
+        if (!config.CacheSegmentation || config.ShareLayouts) return nullptr;
+
+        auto key = GetSegmentationKey(config);
+        if (!data.tape.complete || data.tape.key != key)
+        {
+            data.tape = LayoutTape{};
+            data.tape.key = key;
+        }
+
+        return &data.tape;
+    }
+
+    // Replays the recorded callbacks into the visitor, which is resumable like ParseRichText, 
+    // except that the state refers to events instead of characters. Suspension only happens
+    // where the parser would suspend, i.e. not between a tag and its attributes.
+    static bool ReplayLayoutTape(const LayoutTape& tape, DefaultTagVisitor& visitor, ParserState& state)
+    {
+        using EventType = LayoutTape::EventType;
+
+        if (state.done) return true;
+
+        auto start = std::max(state.idx, 0);
+        auto inTag = start > 0 && (tape.events[start - 1].type == EventType::TagStart || 
+            tape.events[start - 1].type == EventType::Attribute);
+
+        for (auto idx = start; idx < (int)tape.events.size(); ++idx)
+        {
+            const auto& event = tape.events[idx];
+            auto proceed = true;
+
+            if (!inTag && idx != start && visitor.ShouldSuspend())
+            {
+                state.idx = idx;
+                return false;
+            }
+
+            switch (event.type)
+            {
+            case EventType::TagStart: 
+                proceed = visitor.TagStart(event.text); 
+                inTag = true;
+                break;
+            case EventType::Attribute: proceed = visitor.Attribute(event.text, event.value); break;
+            case EventType::TagStartDone: 
+                proceed = visitor.TagStartDone(); 
+                inTag = false;
+                break;
+            case EventType::Content: 
+                proceed = visitor.ReplayContent(event.text, tape.words.data() + event.firstWord, event.wordCount); 
+                break;
+            case EventType::TagEnd: 
+                proceed = visitor.TagEnd(event.text, event.selfTerminating); 
+                inTag = false;
+                break;
+            default: break;
+            }
+
+            if (!proceed)
+            {
+                state.done = true;
+                return false;
+            }
+        }
+
+        visitor.Finalize();
+        state.idx = (int)tape.events.size();
+        state.done = true;
+        return true;
+    }
+
+    // Lays out the text by replaying the tape if it is complete, otherwise by parsing the text
+    // (and recording the tape, if specified)
+    static Drawables GetDrawables(const char* text, const char* textend, const RenderConfig& config, ImVec2 bounds,
+        LayoutTape* tape = nullptr)
+    {
+        IM_RICHTEXT_PROFILE_SCOPE(Parse, textend - text);
         Drawables result;
         DefaultTagVisitor visitor{ config, result, bounds };
-        ParseRichText(text, textend, config.TagStart, config.TagEnd, visitor);
+
+        if (tape != nullptr && tape->complete)
+        {
+            ParserState state;
+            ReplayLayoutTape(*tape, visitor, state);
+        }
+        else
+        {
+            visitor.RecordTape(tape);
+            ParseRichText(text, textend, config.TagStart, config.TagEnd, visitor);
+        }
+
         return result;
     }
 
     static ImVec2 GetBounds(const Drawables& drawables, ImVec2 bounds)
     {
         ImVec2 result = bounds;
-        const auto& style = ImGui::GetCurrentContext()->Style;
+
+        // Text is only offset by the frame padding when shown as an ImGui item
+#ifdef IM_RICHTEXT_TARGET_IMGUI
+        const auto padding = ImGui::GetCurrentContext()->Style.FramePadding;
+#else
+        const ImVec2 padding{ 0.f, 0.f };
+#endif
 
         if (bounds.x == FLT_MAX || bounds.x <= 0.f)
         {
@@ -2912,7 +4367,7 @@ namespace ImRichText
             for (auto depth = 0; depth < IM_RICHTEXT_MAXDEPTH; ++depth)
                 for (const auto& bg : drawables.BackgroundBlocks[depth])
                     width = std::max(width, bg.End.x);
-            result.x = width + (2.f * style.FramePadding.x);
+            result.x = width + (2.f * padding.x);
         }
 
         if (bounds.y == FLT_MAX || bounds.y <= 1.f)
@@ -2929,12 +4384,277 @@ namespace ImRichText
                 if (!drawables.BackgroundBlocks[depth].empty())
                     bgheight = std::max(bgheight, drawables.BackgroundBlocks[depth].back().End.y);
            
-            result.y = std::max(fgheight, bgheight) + (2.f * style.FramePadding.y);
+            result.y = std::max(fgheight, bgheight) + (2.f * padding.y);
+        }
+
+        return result;
+    }
+
+    static void ResetDrawables(Drawables& drawables)
+    {
+        drawables.ForegroundLines.clear();
+        for (auto depth = 0; depth < IM_RICHTEXT_MAXDEPTH; ++depth)
+            drawables.BackgroundBlocks[depth].clear();
+        drawables.StyleDescriptors.clear();
+        drawables.TagDescriptors.clear();
+        drawables.ListItemTokens.clear();
+        drawables.BackgroundMesh.clear();
+        drawables.MarqueeLines.clear();
+        drawables.BlinkSegments.clear();
+        drawables.InteractiveRegions.clear();
+        drawables.BlockIntervals.clear();
+        drawables.MeshPalette = 0;
+        drawables.BoundsComputed = false;
+    }
+
+    // Lays out text only to compute its size, the layout is built into scratch storage which is
+    // reused across calls of the same thread, and nothing is drawn or registered as an item
+    static ImVec2 MeasureImpl(const char* text, const char* end, float width, const RenderConfig& config)
+    {
+        static thread_local Drawables scratch;
+
+        if (end == nullptr) end = text + std::strlen(text);
+        ResetDrawables(scratch);
+
+        ImVec2 bounds{ width, 0.f };
+        IM_RICHTEXT_PROFILE_SCOPE(Parse, end - text);
+        DefaultTagVisitor visitor{ config, scratch, bounds, true };
+        ParseRichText(text, end, config.TagStart, config.TagEnd, visitor);
+        return GetBounds(scratch, bounds);
+    }
+
+    static void RecordLayoutDamage(const Drawables& previous, const Drawables& current, AnimationData& animation,
+        bool restyled);
+
+    // Palette colors are resolved when drawing, hence changing them only requires rebuilding
+    // the background mesh, besides damaging the whole text and invalidating its cached layer
+    static void UpdatePalette(RichTextData& data, const RenderConfig& config)
+    {
+        auto palette = GetPaletteFingerprint(config);
+        auto& drawables = GetLayout(data);
+
+        if (drawables.MeshPalette != palette)
+        {
+            int from[IM_RICHTEXT_MAXDEPTH];
+            for (auto depth = 0; depth < IM_RICHTEXT_MAXDEPTH; ++depth)
+                from[depth] = (int)drawables.BackgroundBlocks[depth].size();
+            AppendBackgroundMesh(drawables, from, config);
+        }
+
+        if (data.palette != palette)
+        {
+            if (data.palette != 0 && config.TrackDamage) data.animationData.fullDamage = true;
+#ifdef IM_RICHTEXT_TARGET_BLEND2D
+            data.layerValid = false;
+#endif
+            data.palette = palette;
+        }
+    }
+
+    // Continues a lazy layout until lines cover the visible height plus margin, also advancing
+    // by the margin every frame, so that the complete text is eventually laid out. Time budgeted 
+    // layouts additionally suspend once the budget for this frame is exhausted.
+    static void ResumeLayout(std::size_t richTextId, RichTextData& data, float visibleHeight)
+    {
+        auto& g = GetContext();
+        auto it = g.LayoutJobs.find(richTextId);
+        if (it == g.LayoutJobs.end()) return;
+
+        auto& job = *it->second;
+        auto config = data.config;
+        job.config = *config; // Equivalent to the copy, except possibly for palette colors
+        
+        if (config->LazyLayout && !job.isStaged)
+            job.visitor.SuspendAt(std::max(visibleHeight, job.visitor.LaidOutHeight()) + config->LazyLayoutMargin);
+        if (config->LayoutTimeBudget > 0.f)
+            job.visitor.SuspendAfter(std::chrono::steady_clock::now() + 
+                std::chrono::microseconds{ (long long)config->LayoutTimeBudget });
+
+        IM_RICHTEXT_PROFILE_SCOPE(Parse, 0);
+        [[maybe_unused]] auto parsedFrom = std::max(job.state.idx, 0);
+        auto isStaged = job.isStaged;
+        auto linesBefore = data.drawables.ForegroundLines.size();
+        auto finalizedBefore = (std::size_t)job.visitor.FinalizedLines();
+        auto complete = job.replay != nullptr ? ReplayLayoutTape(*job.replay, job.visitor, job.state) :
+            ParseRichText(data.richText.data(), data.richText.data() + data.richText.size(), 
+                config->TagStart, config->TagEnd, job.visitor, job.state);
+        IM_RICHTEXT_PROFILE_BYTES(job.replay != nullptr ? 0 : 
+            (complete ? (int)data.richText.size() : job.state.idx) - parsedFrom);
+
+        if (complete)
+        {
+            if (job.isStaged)
+            {
+                if (config->TrackDamage)
+                    RecordLayoutDamage(GetLayout(data), job.staged, data.animationData, true);
+
+                data.drawables = std::move(job.staged);
+                data.sharedLayout.reset();
+                data.animationData.lastHitPos = ImVec2{ -FLT_MAX, -FLT_MAX };
+#ifdef IM_RICHTEXT_TARGET_BLEND2D
+                data.layerValid = false;
+#endif
+            }
+
+            g.LayoutJobs.erase(it);
+        }
+        else if (!job.isStaged)
+            job.visitor.FinalizeLines(false);
+
+        // Lines are appended below the ones laid out so far, and the previous last line (as well
+        // as blocks spanning it) may have been extended. Lines which were not finalized yet (i.e.
+        // of background blocks open until now) may have been recomputed and aligned.
+        if (!isStaged && data.drawables.ForegroundLines.size() > linesBefore)
+        {
+            if (config->TrackDamage)
+            {
+                const auto& lines = data.drawables.ForegroundLines;
+                auto first = std::min(linesBefore > 0u ? linesBefore - 1u : 0u, finalizedBefore);
+                auto top = lines[first].Content.top;
+                data.animationData.layoutDamage.push_back(BoundedBox{ top, 0.f, FLT_MAX, FLT_MAX });
+            }
+
+#ifdef IM_RICHTEXT_TARGET_BLEND2D
+            data.layerValid = false;
+#endif
+        }
+
+        UpdateLayoutMemory(data);
+    }
+
+    // Invoked once the last text referring to the layout releases it, otherwise expired entries
+    // would only be dropped by a later lookup of the same bucket
+    static void ReleaseSharedLayout(Context& g, SharedLayout* layout)
+    {
+        g.LayoutStats.bytes -= layout->bytes;
+        auto it = g.SharedLayouts.find(layout->hash);
+
+        if (it != g.SharedLayouts.end())
+        {
+            auto& candidates = it->second;
+            candidates.erase(std::remove_if(candidates.begin(), candidates.end(), 
+                [](const std::weak_ptr<SharedLayout>& candidate) { return candidate.expired(); }), candidates.end());
+            if (candidates.empty()) g.SharedLayouts.erase(it);
+        }
+
+        delete layout;
+    }
+
+    // Finds the layout of another rich text with the same content, config and bounds, or lays out
+    // the text into a new shared layout, which is released with the last text referring to it.
+    static std::shared_ptr<SharedLayout> GetSharedLayout(const RichTextData& data, const RenderConfig& config)
+    {
+        auto& g = GetContext();
+        auto hash = std::hash<std::string_view>()(data.richText);
+        hash = (hash * 31u) ^ config.Fingerprint;
+        hash = (hash * 31u) ^ std::hash<float>()(data.specifiedBounds.x);
+        hash = (hash * 31u) ^ std::hash<float>()(data.specifiedBounds.y);
+
+        auto& candidates = g.SharedLayouts[hash];
+        std::shared_ptr<SharedLayout> result;
+
+        for (auto it = candidates.begin(); it != candidates.end();)
+        {
+            auto layout = it->lock();
+            if (!layout) { it = candidates.erase(it); continue; }
+
+            if (layout->fingerprint == config.Fingerprint && layout->bounds == data.specifiedBounds &&
+                layout->source == data.richText)
+                result = layout;
+            ++it;
+        }
+
+        if (!result)
+        {
+            result = std::shared_ptr<SharedLayout>(new SharedLayout{}, [&g](SharedLayout* layout) {
+                ReleaseSharedLayout(g, layout); });
+            result->source.assign(data.richText.data(), data.richText.size());
+            result->fingerprint = config.Fingerprint;
+            result->bounds = data.specifiedBounds;
+            result->drawables = GetDrawables(result->source.data(), result->source.data() + result->source.size(),
+                config, data.specifiedBounds);
+            result->hash = hash;
+            result->bytes = EstimateLayoutMemory(result->drawables);
+            g.LayoutStats.bytes += result->bytes;
+            candidates.push_back(result);
         }
 
         return result;
     }
 
+    // With lazy layout (and a specified width), only the lines upto the first page are laid out
+    // here, the rest is laid out by ResumeLayout as it gets scrolled into view. With a time budget,
+    // the layout is built over multiple frames, while the previous layout is displayed (if the text 
+    // itself has not changed, otherwise nothing is drawn).
+    static void StartLayout(std::size_t richTextId, RichTextData& data, const RenderConfig& config, 
+        float visibleHeight, Drawables& previous, std::shared_ptr<SharedLayout> previousShared, bool restyled, 
+        bool textChanged)
+    {
+        auto& g = GetContext();
+        auto lazy = config.LazyLayout && data.specifiedBounds.x > 0.f && data.specifiedBounds.x != FLT_MAX;
+        const auto& old = previousShared ? previousShared->drawables : previous;
+        g.LayoutJobs.erase(richTextId);
+        auto tape = PrepareLayoutTape(data, config);
+
+        if (!lazy && config.LayoutTimeBudget <= 0.f)
+        {
+            if (config.ShareLayouts)
+                data.sharedLayout = GetSharedLayout(data, config);
+            else
+                data.drawables = GetDrawables(data.richText.data(), data.richText.data() + data.richText.size(), 
+                    config, data.specifiedBounds, tape);
+            if (config.TrackDamage) RecordLayoutDamage(old, GetLayout(data), data.animationData, restyled);
+            UpdateLayoutMemory(data);
+            return;
+        }
+
+        if (lazy)
+        {
+            ResetDrawables(data.drawables);
+            g.LayoutJobs.emplace(richTextId, std::make_unique<LayoutJob>(config, &data.drawables, data.specifiedBounds, 
+                tape));
+        }
+        else
+        {
+            if (textChanged) ResetDrawables(data.drawables);
+            else if (previousShared) data.sharedLayout = previousShared;
+            else data.drawables = std::move(previous);
+            g.LayoutJobs.emplace(richTextId, std::make_unique<LayoutJob>(config, nullptr, data.specifiedBounds, tape));
+        }
+
+        ResumeLayout(richTextId, data, visibleHeight);
+
+        // A completed staged layout has recorded its damage already, and the previous
+        // layout is still displayed (i.e. undamaged) if the text has not changed
+        if (config.TrackDamage && g.LayoutJobs.count(richTextId) != 0 && (lazy || textChanged))
+            RecordLayoutDamage(old, GetLayout(data), data.animationData, restyled);
+    }
+
+    // Total height extrapolated from the part of the text laid out so far
+    static float EstimateLayoutHeight(std::size_t richTextId, const RichTextData& data)
+    {
+        auto& g = GetContext();
+        auto it = g.LayoutJobs.find(richTextId);
+        if (it == g.LayoutJobs.end() || it->second->state.idx <= 0) return 0.f;
+        if (it->second->isStaged && !GetLayout(data).ForegroundLines.empty()) return 0.f;
+
+        auto laidOut = it->second->visitor.LaidOutHeight();
+        auto total = it->second->replay != nullptr ? it->second->replay->events.size() : data.richText.size();
+        return laidOut * (float)total / (float)it->second->state.idx;
+    }
+
+    static ImVec2 ComputeBounds(Drawables& drawables, RenderConfig* config, ImVec2 bounds);
+
+    static ImVec2 ComputeBounds(std::size_t richTextId, RichTextData& data, RenderConfig* config)
+    {
+        auto computed = ComputeBounds(GetLayout(data), config, data.specifiedBounds);
+
+        // Height of an incomplete lazy (or placeholder of a time budgeted) layout is only an estimate
+        if (data.specifiedBounds.y == FLT_MAX || data.specifiedBounds.y <= 1.f)
+            computed.y = std::max(computed.y, EstimateLayoutHeight(richTextId, data));
+        return computed;
+    }
+
     static ImVec2 ComputeBounds(Drawables& drawables, RenderConfig* config, ImVec2 bounds)
     {
         auto computed = GetBounds(drawables, bounds);
@@ -2949,32 +4669,223 @@ namespace ImRichText
         return computed;
     }
 
-    std::size_t CreateRichText(const char* text, const char* end)
+    static bool IsSameLine(const DrawableLine& lhs, const Drawables& lhsDrawables,
+        const DrawableLine& rhs, const Drawables& rhsDrawables)
     {
-        if (end == nullptr) end = text + std::strlen(text);
+        if (!IsSameBox(lhs.Content, rhs.Content) || lhs.Segments.size() != rhs.Segments.size())
+            return false;
+
+        for (auto segidx = 0; segidx < (int)lhs.Segments.size(); ++segidx)
+        {
+            const auto& lsegment = lhs.Segments[segidx];
+            const auto& rsegment = rhs.Segments[segidx];
+            const auto& lstyle = lhsDrawables.StyleDescriptors[lsegment.StyleIdx + 1];
+            const auto& rstyle = rhsDrawables.StyleDescriptors[rsegment.StyleIdx + 1];
+
+            if (!IsSameBox(lsegment.Bounds, rsegment.Bounds) || lsegment.Tokens.size() != rsegment.Tokens.size() ||
+                lstyle.fgcolor != rstyle.fgcolor || lstyle.fgslot != rstyle.fgslot || lstyle.font.font != rstyle.font.font ||
+                lstyle.font.size != rstyle.font.size || lstyle.font.flags != rstyle.font.flags || 
+                lstyle.blink != rstyle.blink)
+                return false;
+
+            for (auto tidx = 0; tidx < (int)lsegment.Tokens.size(); ++tidx)
+            {
+                const auto& ltoken = lsegment.Tokens[tidx];
+                const auto& rtoken = rsegment.Tokens[tidx];
+
+                if (ltoken.Type != rtoken.Type || !IsSameBox(ltoken.Bounds, rtoken.Bounds) ||
+                    ltoken.VisibleTextSize != rtoken.VisibleTextSize)
+                    return false;
+
+                if ((ltoken.PropertiesIdx == -1) != (rtoken.PropertiesIdx == -1) || (ltoken.PropertiesIdx != -1 &&
+                    lhsDrawables.TagDescriptors[ltoken.PropertiesIdx] != rhsDrawables.TagDescriptors[rtoken.PropertiesIdx]))
+                    return false;
+            }
+        }
+
+        return true;
+    }
+
+    static bool IsSameBlock(const DrawableBlock& lhs, const DrawableBlock& rhs)
+    {
+        if (lhs.Start.x != rhs.Start.x || lhs.Start.y != rhs.Start.y || lhs.End.x != rhs.End.x ||
+            lhs.End.y != rhs.End.y || lhs.Color != rhs.Color || lhs.ColorSlot != rhs.ColorSlot)
+            return false;
+
+        if (lhs.Shadow.offset.x != rhs.Shadow.offset.x || lhs.Shadow.offset.y != rhs.Shadow.offset.y ||
+            lhs.Shadow.spread != rhs.Shadow.spread || lhs.Shadow.blur != rhs.Shadow.blur ||
+            lhs.Shadow.color != rhs.Shadow.color)
+            return false;
+
+        const Border* lborders[4] = { &lhs.Border.top, &lhs.Border.left, &lhs.Border.bottom, &lhs.Border.right };
+        const Border* rborders[4] = { &rhs.Border.top, &rhs.Border.left, &rhs.Border.bottom, &rhs.Border.right };
+
+        for (auto side = 0; side < 4; ++side)
+            if (lborders[side]->color != rborders[side]->color || lborders[side]->thickness != rborders[side]->thickness ||
+                lborders[side]->lineType != rborders[side]->lineType || lhs.Border.cornerRadius[side] != rhs.Border.cornerRadius[side])
+                return false;
 
-        std::string_view key{ text, (size_t)(end - text) };
-        auto hash = std::hash<std::string_view>()(key);
-        RichTextMap[hash].richText = key;
-        RichTextMap[hash].contentChanged = true;
+        if (lhs.Gradient.totalStops != rhs.Gradient.totalStops || lhs.Gradient.angleDegrees != rhs.Gradient.angleDegrees)
+            return false;
+
+        for (auto stop = 0; stop < lhs.Gradient.totalStops; ++stop)
+            if (lhs.Gradient.colorStops[stop].from != rhs.Gradient.colorStops[stop].from ||
+                lhs.Gradient.colorStops[stop].to != rhs.Gradient.colorStops[stop].to ||
+                lhs.Gradient.colorStops[stop].pos != rhs.Gradient.colorStops[stop].pos)
+                return false;
+
+        return true;
+    }
+
+    static BoundedBox GetDamageBox(const DrawableLine& line)
+    {
+        // Alignment can move any content horizontally, hence damage the complete row
+        return BoundedBox{ line.Content.top, 0.f, FLT_MAX, line.height() };
+    }
+
+    static BoundedBox GetDamageBox(const DrawableBlock& block)
+    {
+        auto extent = block.Shadow.color != IM_COL32_BLACK_TRANS ? std::fabs(block.Shadow.offset.x) + 
+            std::fabs(block.Shadow.offset.y) + block.Shadow.spread + block.Shadow.blur : 0.f;
+        return BoundedBox{ block.Start.y - extent, block.Start.x - extent, 
+            block.End.x - block.Start.x + 2.f * extent, block.End.y - block.Start.y + 2.f * extent };
+    }
+
+    static std::size_t HashLineContent(const DrawableLine& line)
+    {
+        std::size_t hash = 0;
+        for (const auto& segment : line.Segments)
+            for (const auto& token : segment.Tokens)
+                hash = (hash * 31u) ^ std::hash<std::string_view>()(token.Content);
         return hash;
     }
 
-    bool UpdateRichText(std::size_t id, const char* text, const char* end)
+    // Content splices usually only change a few lines, compare old and new layouts so that 
+    // only the lines and background blocks which differ are reported as damaged. Text is 
+    // compared through hashes, as the previous source may not be alive anymore.
+    static void RecordLayoutDamage(const Drawables& previous, const Drawables& current, AnimationData& animation,
+        bool restyled)
+    {
+        auto& damage = animation.layoutDamage;
+        const auto& plines = previous.ForegroundLines;
+        const auto& clines = current.ForegroundLines;
+
+        std::vector<std::size_t> hashes;
+        hashes.reserve(clines.size());
+        for (const auto& line : clines) hashes.push_back(HashLineContent(line));
+
+        std::swap(hashes, animation.lineHashes);
+        animation.fullDamage = animation.fullDamage || restyled;
+        if (animation.fullDamage) return;
+
+        for (auto lineidx = 0; lineidx < (int)std::max(plines.size(), clines.size()); ++lineidx)
+        {
+            if (lineidx >= (int)plines.size()) damage.push_back(GetDamageBox(clines[lineidx]));
+            else if (lineidx >= (int)clines.size()) damage.push_back(GetDamageBox(plines[lineidx]));
+            else if (lineidx >= (int)hashes.size() || hashes[lineidx] != animation.lineHashes[lineidx] ||
+                !IsSameLine(plines[lineidx], previous, clines[lineidx], current))
+            {
+                damage.push_back(GetDamageBox(plines[lineidx]));
+                auto box = GetDamageBox(clines[lineidx]);
+                if (!IsSameBox(box, damage.back())) damage.push_back(box);
+            }
+        }
+
+        for (auto depth = 0; depth < IM_RICHTEXT_MAXDEPTH; ++depth)
+        {
+            const auto& pblocks = previous.BackgroundBlocks[depth];
+            const auto& cblocks = current.BackgroundBlocks[depth];
+
+            for (auto blockidx = 0; blockidx < (int)std::max(pblocks.size(), cblocks.size()); ++blockidx)
+            {
+                if (blockidx >= (int)pblocks.size()) damage.push_back(GetDamageBox(cblocks[blockidx]));
+                else if (blockidx >= (int)cblocks.size()) damage.push_back(GetDamageBox(pblocks[blockidx]));
+                else if (!IsSameBlock(pblocks[blockidx], cblocks[blockidx]))
+                {
+                    damage.push_back(GetDamageBox(pblocks[blockidx]));
+                    auto box = GetDamageBox(cblocks[blockidx]);
+                    if (!IsSameBox(box, damage.back())) damage.push_back(box);
+                }
+            }
+        }
+    }
+
+    // Renderers may cache data for substrings of the text, which are invalid once the layout is discarded
+    static void EvictLayoutCaches(const RichTextData& data)
+    {
+        if (data.renderer != nullptr)
+        {
+            data.renderer->EvictTextCache(data.richText);
+            if (data.sharedLayout && data.sharedLayout.use_count() == 1)
+                data.renderer->EvictTextCache(data.sharedLayout->source);
+        }
+    }
+
+    static void SetRichTextSource(RichTextData& data, const char* text, const char* end, bool ownSource)
+    {
+        if (ownSource)
+        {
+            data.source.assign(text, end);
+            data.richText = data.source;
+        }
+        else
+        {
+            data.richText = std::string_view{ text, (size_t)(end - text) };
+            data.source.clear();
+        }
+
+        data.tape = LayoutTape{};
+        data.contentChanged = true;
+    }
+
+    static void ReleaseRichText(std::size_t index)
+    {
+        auto& g = GetContext();
+        auto& slot = g.RichTextSlots[index];
+        EvictLayoutCaches(slot.data);
+        g.LayoutJobs.erase((slot.generation << RichTextSlotBits) | index);
+        g.LayoutStats.bytes -= slot.data.layoutBytes;
+
+        slot.data = RichTextData{};
+        slot.alive = false;
+        slot.generation = slot.generation == RichTextSlotMask ? 1u : slot.generation + 1u;
+        g.FreeRichTextSlots.push_back(index);
+    }
+
+    std::size_t CreateRichText(const char* text, const char* end, bool ownSource)
     {
-        auto rit = RichTextMap.find(id);
+        auto& g = GetContext();
+        if (end == nullptr) end = text + std::strlen(text);
 
-        if (rit != RichTextMap.end())
+        auto index = g.RichTextSlots.size();
+        if (!g.FreeRichTextSlots.empty())
+        {
+            index = g.FreeRichTextSlots.back();
+            g.FreeRichTextSlots.pop_back();
+        }
+        else
+            g.RichTextSlots.emplace_back();
+
+        auto& slot = g.RichTextSlots[index];
+        slot.alive = true;
+        SetRichTextSource(slot.data, text, end, ownSource);
+        return (slot.generation << RichTextSlotBits) | index;
+    }
+
+    bool UpdateRichText(std::size_t id, const char* text, const char* end, bool ownSource)
+    {
+        auto data = FindRichText(id);
+
+        if (data != nullptr)
         {
             if (end == nullptr) end = text + std::strlen(text);
 
-            std::string_view existingKey{ rit->second.richText };
             std::string_view key{ text, (size_t)(end - text) };
 
-            if (key != existingKey)
+            if (key != data->richText || ownSource != !data->source.empty())
             {
-                RichTextMap[id].richText = key;
-                RichTextMap[id].contentChanged = true;
+                EvictLayoutCaches(*data);
+                SetRichTextSource(*data, text, end, ownSource);
                 return true;
             }
         }
@@ -2984,11 +4895,9 @@ namespace ImRichText
 
     bool RemoveRichText(std::size_t id)
     {
-        auto it = RichTextMap.find(id);
-
-        if (it != RichTextMap.end())
+        if (FindRichText(id) != nullptr)
         {
-            RichTextMap.erase(it);
+            ReleaseRichText(id & RichTextSlotMask);
             return true;
         }
 
@@ -2997,52 +4906,277 @@ namespace ImRichText
 
     void ClearAllRichTexts()
     {
-        RichTextMap.clear();
+        auto& g = GetContext();
+        for (auto index = 0u; index < g.RichTextSlots.size(); ++index)
+            if (g.RichTextSlots[index].alive)
+                ReleaseRichText(index);
+    }
+
+    const std::vector<BoundedBox>& GetDamagedRegions(std::size_t richTextId)
+    {
+        static const std::vector<BoundedBox> NoDamage;
+        auto data = FindRichText(richTextId);
+        return data != nullptr ? data->animationData.damage : NoDamage;
+    }
+
+    long long NextAnimationDeadline()
+    {
+        auto& g = GetContext();
+        long long deadline = -1;
+
+        for (auto& slot : g.RichTextSlots)
+        {
+            if (!slot.alive) continue;
+
+            auto& animation = slot.data.animationData;
+            if (animation.drawn && animation.nextDeadline != -1)
+                deadline = deadline == -1 ? animation.nextDeadline : std::min(deadline, animation.nextDeadline);
+            animation.drawn = false;
+        }
+
+        return deadline;
+    }
+
+    // Drops the layout of a text, which is recreated (as if its content changed) when shown next
+    static void EvictLayout(std::size_t index)
+    {
+        auto& g = GetContext();
+        auto& slot = g.RichTextSlots[index];
+        auto& data = slot.data;
+        EvictLayoutCaches(data);
+        g.LayoutJobs.erase((slot.generation << RichTextSlotBits) | index);
+        g.LayoutStats.bytes -= data.layoutBytes;
+
+        data.layoutBytes = 0;
+        data.drawables = Drawables{};
+        data.sharedLayout.reset();
+        data.tape = LayoutTape{};
+        data.contentChanged = true;
+        data.evicted = true;
+#ifdef IM_RICHTEXT_TARGET_BLEND2D
+        data.layer.reset();
+        data.layerValid = false;
+#endif
+        ++g.LayoutStats.evictions;
+    }
+
+    static void EvictIdleLayouts()
+    {
+        auto& g = GetContext();
+        if (g.LayoutMemoryBudget == 0 || g.LayoutStats.bytes <= g.LayoutMemoryBudget) return;
+
+        std::vector<std::size_t> candidates;
+        for (auto index = 0u; index < g.RichTextSlots.size(); ++index)
+        {
+            const auto& slot = g.RichTextSlots[index];
+            if (slot.alive && (slot.data.layoutBytes > 0 || slot.data.sharedLayout) && 
+                slot.data.lastShownFrame + g.LayoutIdleFrames <= g.LayoutFrame)
+                candidates.push_back(index);
+        }
+
+        std::sort(candidates.begin(), candidates.end(), [&g](std::size_t lhs, std::size_t rhs) {
+            return g.RichTextSlots[lhs].data.lastShownFrame < g.RichTextSlots[rhs].data.lastShownFrame;
+        });
+
+        for (auto index : candidates)
+        {
+            if (g.LayoutStats.bytes <= g.LayoutMemoryBudget) break;
+            EvictLayout(index);
+        }
+    }
+
+    static void AdvanceLayoutFrame(std::size_t frame)
+    {
+        auto& g = GetContext();
+        if (frame == g.LayoutFrame) return;
+        g.LayoutFrame = frame;
+        EvictIdleLayouts();
+
+#ifdef IM_RICHTEXT_ENABLE_PROFILING
+        g.LastFrameProfile = g.FrameProfile;
+        g.FrameProfile = ProfileCounters{};
+#endif
+    }
+
+    void SetLayoutMemoryBudget(std::size_t budget, int idleFrames)
+    {
+        auto& g = GetContext();
+        g.LayoutMemoryBudget = budget;
+        g.LayoutIdleFrames = (std::size_t)std::max(idleFrames, 1);
+    }
+
+    LayoutCacheStats GetLayoutCacheStats()
+    {
+        auto& g = GetContext();
+        return g.LayoutStats;
+    }
+
+#ifdef IM_RICHTEXT_ENABLE_PROFILING
+    void SetProfilerHooks(const ProfilerHooks& hooks)
+    {
+        Profiler = hooks;
+    }
+
+    const char* GetProfilePhaseName(ProfilePhase phase)
+    {
+        switch (phase)
+        {
+        case ProfilePhase::Parse: return "Parse";
+        case ProfilePhase::Segmentation: return "Segmentation";
+        case ProfilePhase::Measurement: return "Measurement";
+        case ProfilePhase::WordWrap: return "WordWrap";
+        case ProfilePhase::Geometry: return "Geometry";
+        case ProfilePhase::Finalize: return "Finalize";
+        case ProfilePhase::Draw: return "Draw";
+        default: return "Unknown";
+        }
+    }
+
+    const ProfileCounters& GetProfileCounters(std::size_t richTextId)
+    {
+        static const ProfileCounters NoCounters;
+        auto data = FindRichText(richTextId);
+        return data != nullptr ? data->profile : NoCounters;
+    }
+
+    const ProfileCounters& GetFrameProfileCounters()
+    {
+        auto& g = GetContext();
+        return g.LastFrameProfile;
+    }
+#endif
+
+    static void AddSourceStats(RichTextMemoryStats& stats, const std::string& source)
+    {
+        stats.source.count += source.size();
+        stats.source.bytes += source.capacity();
+        stats.source.slack += source.capacity() - source.size();
+        stats.total += source.capacity();
+    }
+
+    static void AddRichTextStats(RichTextMemoryStats& stats, const RichTextData& data, bool withLayout)
+    {
+        const auto& animation = data.animationData;
+        stats.animation.count++;
+        stats.animation.bytes += sizeof(AnimationData);
+        stats.total += sizeof(AnimationData);
+        AddContainerStats(stats, stats.animation, animation.xoffsets);
+        AddContainerStats(stats, stats.animation, animation.damage);
+        AddContainerStats(stats, stats.animation, animation.layoutDamage);
+        AddContainerStats(stats, stats.animation, animation.pendingDamage);
+        AddContainerStats(stats, stats.animation, animation.lineHashes);
+
+        AddSourceStats(stats, data.source);
+        AddTapeStats(stats, data.tape);
+
+        if (withLayout)
+        {
+            AddLayoutStats(stats, GetLayout(data));
+            if (data.sharedLayout) AddSourceStats(stats, data.sharedLayout->source);
+        }
+
+        stats.documents++;
+    }
+
+    RichTextMemoryStats GetRichTextMemoryStats(std::size_t richTextId)
+    {
+        RichTextMemoryStats stats;
+        auto data = FindRichText(richTextId);
+        if (data != nullptr) AddRichTextStats(stats, *data, true);
+        return stats;
+    }
+
+    RichTextMemoryStats GetRichTextMemoryStats()
+    {
+        auto& g = GetContext();
+        RichTextMemoryStats stats;
+        std::vector<const SharedLayout*> shared;
+
+        for (const auto& slot : g.RichTextSlots)
+        {
+            if (!slot.alive) continue;
+            AddRichTextStats(stats, slot.data, !slot.data.sharedLayout);
+
+            if (slot.data.sharedLayout) 
+                shared.push_back(slot.data.sharedLayout.get());
+        }
+
+        std::sort(shared.begin(), shared.end());
+        shared.erase(std::unique(shared.begin(), shared.end()), shared.end());
+
+        for (auto layout : shared)
+        {
+            AddLayoutStats(stats, layout->drawables);
+            AddSourceStats(stats, layout->source);
+        }
+
+        return stats;
     }
 
 #ifdef IM_RICHTEXT_TARGET_IMGUI
 
     static bool Render(ImVec2 pos, std::size_t richTextId, std::optional<ImVec2> sz, bool show)
     {
-        auto it = RichTextMap.find(richTextId);
+        auto& g = GetContext();
+        AdvanceLayoutFrame((std::size_t)ImGui::GetFrameCount());
+        auto data = FindRichText(richTextId);
 
-        if (it != RichTextMap.end())
+        if (data != nullptr)
         {
-            auto& drawdata = it->second;
+            auto& drawdata = *data;
             auto config = GetRenderConfig();
+            auto fingerprint = GetConfigFingerprint(*config);
+            IM_RICHTEXT_PROFILE_TARGET(richTextId, drawdata.profile);
+            auto visibleHeight = show ? ImGui::GetCurrentWindow()->ClipRect.Max.y - pos.y : 0.f;
+
+            // Equivalent configs can be used interchangeably, hence only the pointer is updated
+            drawdata.config = config;
 
-            if (config != drawdata.config || config->Scale != drawdata.scale ||
-                config->FontScale != drawdata.fontScale || config->DefaultBgColor != drawdata.bgcolor
-                || (sz.has_value() && sz.value() != drawdata.specifiedBounds) || drawdata.contentChanged)
+            if (fingerprint != drawdata.fingerprint || (sz.has_value() && sz.value() != drawdata.specifiedBounds) 
+                || drawdata.contentChanged)
             {
+                auto restyled = fingerprint != drawdata.fingerprint;
+                EvictLayoutCaches(drawdata);
+                if (drawdata.evicted) ++g.LayoutStats.relayouts;
+                drawdata.evicted = false;
+                auto textChanged = drawdata.contentChanged || GetLayout(drawdata).ForegroundLines.empty();
                 drawdata.contentChanged = false;
-                drawdata.config = config;
-                drawdata.bgcolor = config->DefaultBgColor;
-                drawdata.scale = config->Scale;
-                drawdata.fontScale = config->FontScale;
+                drawdata.fingerprint = fingerprint;
                 drawdata.specifiedBounds = sz.has_value() ? sz.value() : drawdata.specifiedBounds;
                 config->Renderer->UserData = ImGui::GetCurrentWindow()->DrawList;
+                auto previous = std::move(drawdata.drawables);
+                auto previousShared = std::move(drawdata.sharedLayout);
+                drawdata.animationData.lastHitPos = ImVec2{ -FLT_MAX, -FLT_MAX };
 
 #ifdef _DEBUG
                 auto ts = std::chrono::duration_cast<std::chrono::microseconds>(
                     std::chrono::high_resolution_clock().now().time_since_epoch());
 
-                drawdata.drawables = GetDrawables(drawdata.richText.data(),
-                    drawdata.richText.data() + drawdata.richText.size(), *config,
-                    drawdata.specifiedBounds);
+                StartLayout(richTextId, drawdata, *config, visibleHeight, previous, previousShared, restyled, 
+                    textChanged);
 
                 ts = std::chrono::duration_cast<std::chrono::microseconds>(
                     std::chrono::high_resolution_clock().now().time_since_epoch()) - ts;
                 HIGHLIGHT("\nParsing [#%d] took %lldus", (int)richTextId, ts.count());
 #else
-                drawdata.drawables = GetDrawables(drawdata.richText.data(),
-                    drawdata.richText.data() + drawdata.richText.size(), *config,
-                    drawdata.specifiedBounds);
+                StartLayout(richTextId, drawdata, *config, visibleHeight, previous, previousShared, restyled, 
+                    textChanged);
 #endif
             }
+            else if (show) ResumeLayout(richTextId, drawdata, visibleHeight);
 
-            drawdata.computedBounds = ComputeBounds(drawdata.drawables, config, drawdata.specifiedBounds);
-            ShowDrawables(pos, drawdata.richText, richTextId, drawdata.drawables, drawdata.computedBounds, config);
+            // Updated once caches of the previous renderer (the renderer is part of the fingerprint) 
+            // were evicted by the relayout
+            drawdata.renderer = config->Renderer;
+
+            if (show)
+            {
+                drawdata.lastShownFrame = g.LayoutFrame;
+                UpdatePalette(drawdata, *config);
+            }
+
+            drawdata.computedBounds = ComputeBounds(richTextId, drawdata, config);
+            if (show) ShowDrawables(pos, drawdata.richText, richTextId, GetLayout(drawdata), drawdata.computedBounds, config);
             return true;
         }
 
@@ -3052,7 +5186,7 @@ namespace ImRichText
     ImVec2 GetBounds(std::size_t richTextId)
     {
         if (Render({}, richTextId, std::nullopt, false))
-            return RichTextMap.at(richTextId).computedBounds;
+            return FindRichText(richTextId)->computedBounds;
         return ImVec2{ 0.f, 0.f };
     }
 
@@ -3066,6 +5200,142 @@ namespace ImRichText
         return Render(pos, richTextId, sz, true);
     }
 
+    ImVec2 MeasureRichText(const char* text, float width, const char* end)
+    {
+        return MeasureImpl(text, end, width, *GetRenderConfig());
+    }
+
+    RichTextList::RichTextList(float estimatedHeight)
+        : _estimatedHeight{ estimatedHeight }
+    {}
+
+    RichTextList::~RichTextList()
+    {
+        Clear();
+    }
+
+    double RichTextList::Prefix(int count) const
+    {
+        auto sum = 0.0;
+        for (; count > 0; count -= count & -count)
+            sum += _tree[count - 1];
+        return sum;
+    }
+
+    void RichTextList::UpdateHeight(int index, float height)
+    {
+        auto delta = (double)height - (double)_items[index].height;
+        _items[index].height = height;
+        for (auto pos = index + 1; pos <= (int)_tree.size(); pos += pos & -pos)
+            _tree[pos - 1] += delta;
+    }
+
+    void RichTextList::Release(Item& item)
+    {
+        if (item.id == 0) return;
+
+        RemoveRichText(item.id);
+        item.id = 0;
+    }
+
+    int RichTextList::ItemAt(float offset) const
+    {
+        // Descend the Fenwick tree to find the first item whose end lies beyond offset
+        auto pos = 0, total = (int)_tree.size();
+        auto remaining = (double)offset;
+        auto step = 1;
+        while (step * 2 <= total) step *= 2;
+
+        for (; step > 0; step /= 2)
+        {
+            if (pos + step <= total && _tree[pos + step - 1] <= remaining)
+            {
+                pos += step;
+                remaining -= _tree[pos - 1];
+            }
+        }
+
+        return std::min(pos, total - 1);
+    }
+
+    int RichTextList::Add(const char* text, const char* end)
+    {
+        if (end == nullptr) end = text + std::strlen(text);
+
+        if (_estimatedHeight <= 0.f)
+        {
+            auto config = GetRenderConfig();
+            _estimatedHeight = (config->DefaultFontSize * config->FontScale * config->Scale) + 
+                (2.f * ImGui::GetStyle().FramePadding.y);
+        }
+
+        auto& item = _items.emplace_back();
+        item.text = std::string_view{ text, (size_t)(end - text) };
+        item.height = _estimatedHeight;
+
+        // Appending to a Fenwick tree: node n covers the items (n - lowbit(n), n]
+        auto count = (int)_items.size();
+        _tree.push_back(Prefix(count - 1) - Prefix(count - (count & -count)) + item.height);
+        return count - 1;
+    }
+
+    void RichTextList::Set(int index, const char* text, const char* end)
+    {
+        if (index < 0 || index >= (int)_items.size()) return;
+        if (end == nullptr) end = text + std::strlen(text);
+
+        // Previous height is kept as the estimate until the item is visible again
+        Release(_items[index]);
+        _items[index].text = std::string_view{ text, (size_t)(end - text) };
+    }
+
+    void RichTextList::Clear()
+    {
+        for (auto& item : _items) Release(item);
+        _items.clear();
+        _tree.clear();
+        _visible.clear();
+    }
+
+    void RichTextList::Show()
+    {
+        auto window = ImGui::GetCurrentWindow();
+        if (window->SkipItems || _items.empty()) return;
+
+        // ImGuiListClipper requires uniform item heights, hence the visible range is instead
+        // found by descending the height index with the window's clip rect.
+        auto start = window->DC.CursorPos;
+        auto width = ImGui::GetContentRegionAvail().x;
+        auto top = std::max(window->ClipRect.Min.y - start.y, 0.f);
+        auto bottom = window->ClipRect.Max.y - start.y;
+
+        auto first = ItemAt(top), index = first;
+        auto offset = Prefix(index);
+
+        for (; index < (int)_items.size() && offset < (double)bottom; ++index)
+        {
+            auto& item = _items[index];
+
+            if (item.id == 0) item.id = CreateRichText(item.text.data(), item.text.data() + item.text.size());
+
+            ImRichText::Show(ImVec2{ start.x, start.y + (float)offset }, item.id, ImVec2{ width, 0.f });
+            auto height = FindRichText(item.id)->computedBounds.y;
+            if (height != item.height) UpdateHeight(index, height);
+            offset += height;
+        }
+
+        // Evict layouts of items which scrolled out of view
+        for (auto idx : _visible)
+            if (idx < (int)_items.size() && (idx < first || idx >= index))
+                Release(_items[idx]);
+
+        _visible.clear();
+        for (auto idx = first; idx < index; ++idx) _visible.push_back(idx);
+
+        ImGui::SetCursorScreenPos(start);
+        ImGui::Dummy(ImVec2{ width, TotalHeight() });
+    }
+
     bool ToggleOverlay()
     {
 #ifdef _DEBUG
@@ -3074,49 +5344,84 @@ namespace ImRichText
 #endif
         return ShowOverlay;
     }
+
 #endif
 #ifdef IM_RICHTEXT_TARGET_BLEND2D
 
     static bool Render(BLContext& context, ImVec2 pos, std::size_t richTextId, std::optional<ImVec2> sz, bool show)
     {
-        auto it = RichTextMap.find(richTextId);
+        auto& g = GetContext();
+        auto data = FindRichText(richTextId);
 
-        if (it != RichTextMap.end())
+        if (data != nullptr)
         {
-            auto& drawdata = RichTextMap[richTextId];
+            auto& drawdata = *data;
             auto config = GetRenderConfig(context);
+            auto fingerprint = GetConfigFingerprint(*config);
+            IM_RICHTEXT_PROFILE_TARGET(richTextId, drawdata.profile);
+            auto visibleHeight = show ? (float)context.targetHeight() - pos.y : 0.f;
 
-            if (config != drawdata.config || config->Scale != drawdata.scale ||
-                config->FontScale != drawdata.fontScale || config->DefaultBgColor != drawdata.bgcolor
-                || (sz.has_value() && sz.value() != drawdata.specifiedBounds) || drawdata.contentChanged)
+            // Equivalent configs can be used interchangeably, hence only the pointer is updated
+            drawdata.config = config;
+
+            if (fingerprint != drawdata.fingerprint || (sz.has_value() && sz.value() != drawdata.specifiedBounds) 
+                || drawdata.contentChanged)
             {
+                auto restyled = fingerprint != drawdata.fingerprint;
+                EvictLayoutCaches(drawdata);
+                if (drawdata.evicted) ++g.LayoutStats.relayouts;
+                drawdata.evicted = false;
+                auto textChanged = drawdata.contentChanged || GetLayout(drawdata).ForegroundLines.empty();
                 drawdata.contentChanged = false;
-                drawdata.config = config;
-                drawdata.bgcolor = config->DefaultBgColor;
-                drawdata.scale = config->Scale;
-                drawdata.fontScale = config->FontScale;
+                drawdata.fingerprint = fingerprint;
                 drawdata.specifiedBounds = sz.has_value() ? sz.value() : drawdata.specifiedBounds;
+                auto previous = std::move(drawdata.drawables);
+                auto previousShared = std::move(drawdata.sharedLayout);
+                drawdata.animationData.lastHitPos = ImVec2{ -FLT_MAX, -FLT_MAX };
 
 #ifdef _DEBUG
                 auto ts = std::chrono::duration_cast<std::chrono::microseconds>(
                     std::chrono::high_resolution_clock().now().time_since_epoch());
 
-                drawdata.drawables = GetDrawables(drawdata.richText.data(),
-                    drawdata.richText.data() + drawdata.richText.size(), *config,
-                    drawdata.specifiedBounds);
+                StartLayout(richTextId, drawdata, *config, visibleHeight, previous, previousShared, restyled, 
+                    textChanged);
 
                 ts = std::chrono::duration_cast<std::chrono::microseconds>(
                     std::chrono::high_resolution_clock().now().time_since_epoch()) - ts;
                 HIGHLIGHT("\nParsing [#%d] took %lldus", (int)richTextId, ts.count());
 #else
-                drawdata.drawables = GetDrawables(drawdata.richText.data(),
-                    drawdata.richText.data() + drawdata.richText.size(), *config,
-                    drawdata.specifiedBounds);
+                StartLayout(richTextId, drawdata, *config, visibleHeight, previous, previousShared, restyled, 
+                    textChanged);
 #endif
+
+                drawdata.layerValid = false;
+            }
+            else if (show) ResumeLayout(richTextId, drawdata, visibleHeight);
+
+            // Updated once caches of the previous renderer (the renderer is part of the fingerprint) 
+            // were evicted by the relayout
+            drawdata.renderer = config->Renderer;
+
+            if (show)
+            {
+                drawdata.lastShownFrame = g.LayoutFrame;
+                UpdatePalette(drawdata, *config);
             }
 
-            drawdata.computedBounds = ComputeBounds(drawdata.drawables, config, drawdata.specifiedBounds);
-            ShowDrawables(context, pos, richTextId, drawdata.drawables, drawdata.computedBounds, config);
+            drawdata.computedBounds = ComputeBounds(richTextId, drawdata, config);
+            if (!show) return true;
+
+            // Layers are only rendered once the layout is complete, as lazy or time budgeted
+            // layouts change every frame until then
+            if (config->UseLayerCache && !HasAnimations(GetLayout(drawdata)) && g.LayoutJobs.count(richTextId) == 0 &&
+                (drawdata.layerValid || RenderLayer(drawdata, config)))
+            {
+                context.blitImage(BLPoint{ pos.x, pos.y }, drawdata.layer);
+                if (config->TrackDamage) BeginDamageFrame(drawdata.animationData, pos, drawdata.computedBounds);
+            }
+            else
+                ShowDrawables(context, pos, richTextId, GetLayout(drawdata), drawdata.computedBounds, config);
+
             return true;
         }
 
@@ -3126,7 +5431,7 @@ namespace ImRichText
     ImVec2 GetBounds(BLContext& context, std::size_t richTextId)
     {
         if (Render(context, {}, richTextId, std::nullopt, false))
-            return RichTextMap.at(richTextId).computedBounds;
+            return FindRichText(richTextId)->computedBounds;
         return ImVec2{ 0.f, 0.f };
     }
 
@@ -3134,6 +5439,46 @@ namespace ImRichText
     {
         return Render(context, pos, richTextId, sz, true);
     }
+
+    ImVec2 MeasureRichText(BLContext& context, const char* text, float width, const char* end)
+    {
+        return MeasureImpl(text, end, width, *GetRenderConfig(context));
+    }
+
+    void NewFrame()
+    {
+        auto& g = GetContext();
+        AdvanceLayoutFrame(g.LayoutFrame + 1u);
+    }
     
 #endif
+
+    std::vector<uint32_t> RenderToBuffer(std::size_t richTextId, int width, int height, const RenderConfig& config,
+        IGlyphSource* glyphs)
+    {
+        auto data = FindRichText(richTextId);
+        if (data == nullptr || width <= 0 || height <= 0) return {};
+
+#ifdef IM_RICHTEXT_TARGET_IMGUI
+        ImGuiGlyphSource defaultGlyphs;
+#else
+        Blend2DGlyphSource defaultGlyphs;
+#endif
+
+        // Layout with a copy of the config, so that text is measured by the software renderer,
+        // and the cached drawables of on-screen rendering are left untouched
+        SoftwareRenderer renderer{ glyphs != nullptr ? *glyphs : defaultGlyphs, width, height };
+        auto swconfig = config;
+        swconfig.Renderer = &renderer;
+        swconfig.Platform = nullptr;
+
+        ImVec2 bounds{ (float)width, (float)height };
+        const auto& richText = data->richText;
+        auto drawables = GetDrawables(richText.data(), richText.data() + richText.size(), swconfig, bounds);
+        ComputeBounds(drawables, &swconfig, bounds);
+
+        AnimationData animation{};
+        DrawImpl(animation, drawables, ImVec2{ 0.f, 0.f }, bounds, &swconfig);
+        return std::move(renderer.pixels);
+    }
 }
\ No newline at end of file
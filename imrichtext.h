@@ -12,7 +12,11 @@
 
 #include <string_view>
 #include <vector>
+#include <memory>
 #include <stdint.h>
+#ifdef IM_RICHTEXT_ENABLE_PROFILING
+#include <chrono>
+#endif
 
 #define IM_RICHTEXT_DEFAULT_FONTFAMILY "default-font-family"
 #define IM_RICHTEXT_MONOSPACE_FONTFAMILY "monospace"
@@ -150,10 +154,23 @@ namespace ImRichText
         TextAlignLeading = TextAlignLeft | TextAlignVCenter
     };
 
+    // Colors of the config which are referred to by layouts, and resolved when drawing. Hence
+    // they can be changed (e.g. when switching themes) without laying out the text again.
+    enum class PaletteSlot : uint8_t
+    {
+        None, // Literal color
+        DefaultFg,
+        Hyperlink,
+        HeaderLine,
+        MarkHighlight,
+        CodeBlockBg
+    };
+
     struct StyleDescriptor
     {
         int64_t propsSpecified = NoStyleChange;
         uint32_t fgcolor = IM_COL32_BLACK;
+        PaletteSlot fgslot = PaletteSlot::None; // Overrides fgcolor unless None
         float height = 0;
         float width = 0;
         FontStyle font;
@@ -200,6 +217,7 @@ namespace ImRichText
     {
         ImVec2 Start{ -1.f, -1.f }, End{ -1.f, -1.f }, ViewportPos{ 0.f, 0.f };
         uint32_t Color = IM_COL32_BLACK_TRANS;
+        PaletteSlot ColorSlot = PaletteSlot::None; // Overrides Color unless None
         FourSidedMeasure padding;
         FourSidedMeasure margin;
         FourSidedBorder Border;
@@ -223,7 +241,7 @@ namespace ImRichText
     {
         Fast,     // Shadow corners are hard triangles
         Balanced, // Shadow corners are rounded (with coarse roundedness)
-        High      // Unimplemented
+        High      // Cached gaussian falloff, drawn as a vertex colored mesh
     };
 
     struct RenderConfig
@@ -233,6 +251,7 @@ namespace ImRichText
         IPlatform* Platform = nullptr;
         IRenderer* Renderer = nullptr;
         BoxShadowQuality ShadowQuality = BoxShadowQuality::Fast;
+        bool TrackDamage = false; // Record regions changed between frames, see GetDamagedRegions()
 
 #ifdef _DEBUG
         IRenderer* OverlayRenderer = nullptr;
@@ -254,6 +273,11 @@ namespace ImRichText
 
         float  LineGap = 5;
         bool   WordWrap = true;
+        bool   LazyLayout = false; // Layout lines (of documents with a width) as they are scrolled into view
+        float  LazyLayoutMargin = 512.f; // Height laid out beyond the visible region, and per frame
+        float  LayoutTimeBudget = 0.f; // Microseconds spent on layout per text per frame, 0 = unlimited
+        bool   ShareLayouts = false; // Texts with identical content, config and bounds share one layout
+        bool   CacheSegmentation = false; // Keep parsed tags and words, relayout (e.g. for scale) only measures and wraps
 
         int   ParagraphStop = 4;
         int   TabStop = 4;
@@ -263,6 +287,7 @@ namespace ImRichText
 
         std::string_view DefaultFontFamily = IM_RICHTEXT_DEFAULT_FONTFAMILY;
         float    DefaultFontSize = 24.f;
+        // Changing colors does not require relayout, see PaletteSlot
         uint32_t DefaultFgColor = IM_COL32_BLACK;
         uint32_t DefaultBgColor = IM_COL32_WHITE;
         uint32_t MarkHighlight = ToRGBA(255, 255, 0);
@@ -292,6 +317,16 @@ namespace ImRichText
 
         bool IsStrictHTML5 = false;
 
+        // Hash of the members affecting layout, computed when the config is pushed or created. Texts 
+        // laid out with one config are not laid out again for a different config with the same 
+        // fingerprint. Set to 0 after modifying a config which has already been pushed.
+        std::size_t Fingerprint = 0;
+
+#ifdef IM_RICHTEXT_TARGET_BLEND2D
+        bool     UseLayerCache = false; // Render static content once offscreen, blit on later frames
+        uint32_t RenderThreadCount = 0; // Worker threads for offscreen layer rendering (0 = synchronous)
+#endif
+
 #ifdef _DEBUG
         uint32_t DebugContents[ContentTypeTotal] = {
             IM_COL32_BLACK_TRANS, IM_COL32_BLACK_TRANS, 
@@ -300,6 +335,21 @@ namespace ImRichText
 #endif
     };
 
+    // Link or tooltip token, which reacts to mouse hover/clicks
+    struct InteractiveRegion
+    {
+        BoundedBox Bounds; // Relative to the document origin, i.e. not offset by the draw position
+        int LineIdx = -1;
+        int PropertiesIdx = -1;
+    };
+
+    struct BlockInterval
+    {
+        float top = 0.f, bottom = 0.f;
+        float maxBottom = 0.f; // Maximum bottom within the subtree rooted at this interval, see BlockIntervals
+        int depth = 0, index = 0;
+    };
+
     struct Drawables
     {
         std::vector<DrawableLine>  ForegroundLines;
@@ -307,6 +357,13 @@ namespace ImRichText
         std::vector<StyleDescriptor> StyleDescriptors;
         std::vector<TagPropertyDescriptor>   TagDescriptors;
         std::vector<ListItemTokenDescriptor> ListItemTokens;
+        MeshData BackgroundMesh; // Shadows, backgrounds and borders, relative to origin
+        std::vector<int> MarqueeLines; // Indices of scrolling lines, in ascending order
+        std::vector<std::pair<int, int>> BlinkSegments; // (line, segment) indices of blinking content
+        std::vector<InteractiveRegion> InteractiveRegions; // Sorted by line, then left edge
+        std::vector<BlockInterval> BlockIntervals; // Background blocks sorted by top edge, forming an implicit
+                                                   // interval tree (the middle of each range is its root)
+        std::size_t MeshPalette = 0; // Palette colors baked into BackgroundMesh
         bool BoundsComputed = false;
     };
 
@@ -318,37 +375,237 @@ namespace ImRichText
         TextContentCharset Charset = TextContentCharset::ASCII;
     };
 
+    // Library state, i.e. rich texts and their layouts, pushed configs, layout caches and the fonts
+    // loaded through imrichtextfont.h (if present). Threads use a process-wide default context until
+    // they set their own, hence contexts can be created per thread, window or ImGui context (and set
+    // along with ImGui::SetCurrentContext). Rich text handles are only valid in the context which
+    // created them, and a context must not be used by multiple threads at once.
+    struct Context;
+
+    [[nodiscard]] Context* CreateContext();
+    void DestroyContext(Context* context = nullptr); // Destroys the current context if nullptr
+    void SetCurrentContext(Context* context); // Selects the default context if nullptr
+    [[nodiscard]] Context* GetCurrentContext();
+
     // RenderConfig related functions. In order to render rich text, such configs should be pushed/popped as desired 
     [[nodiscard]] RenderConfig* GetDefaultConfig(const DefaultConfigParams& params);
 
+    // Immutable config, shared by everything which pushed it
+    using RenderConfigHandle = std::shared_ptr<const RenderConfig>;
+
+    // Create an immutable copy of the config, with derived values (header font sizes, fingerprint)
+    // computed once. Pushing the handle does not copy the config, prefer it for per-widget pushes.
+    [[nodiscard]] RenderConfigHandle CreateConfig(const RenderConfig& config);
+
     // Create the correct text shaper engine based on charset support
     [[nodiscard]] ITextShaper* CreateTextShaper(TextContentCharset charset);
 
 #ifdef IM_RICHTEXT_TARGET_IMGUI
     [[nodiscard]] RenderConfig* GetCurrentConfig();
     void PushConfig(RenderConfig& config);
+    void PushConfig(const RenderConfigHandle& config);
     void PopConfig();
 #endif
 #ifdef IM_RICHTEXT_TARGET_BLEND2D
     [[nodiscard]] RenderConfig* GetCurrentConfig(BLContext& context);
     void PushConfig(RenderConfig& config, BLContext& context);
+    void PushConfig(const RenderConfigHandle& config, BLContext& context);
     void PopConfig(BLContext& context);
 #endif
 
-    // Create cacheable rich text content
-    [[nodiscard]] std::size_t CreateRichText(const char* text, const char* end = nullptr);
-    bool UpdateRichText(std::size_t id, const char* text, const char* end = nullptr);
+    // Create cacheable rich text content, returns a handle which stays unique even if the text is
+    // removed. The text is referred to, unless `ownSource` is set, in which case it is copied.
+    [[nodiscard]] std::size_t CreateRichText(const char* text, const char* end = nullptr, bool ownSource = false);
+    bool UpdateRichText(std::size_t id, const char* text, const char* end = nullptr, bool ownSource = false);
     bool RemoveRichText(std::size_t id);
     void ClearAllRichTexts();
 
+    // Time (in milliseconds since std::chrono::system_clock epoch) at which the next blink/marquee
+    // step is due, among documents drawn since the previous call. Returns -1 if none of them are
+    // animated, so that event driven hosts can sleep until the deadline instead of polling.
+    [[nodiscard]] long long NextAnimationDeadline();
+
+    // Regions (in screen coordinates) which changed visually since the previous frame, due to
+    // relayout, animation steps or hover changes. Requires `RenderConfig::TrackDamage` to be set,
+    // hosts with retained surfaces can then restrict clipping and repaint to these regions.
+    [[nodiscard]] const std::vector<BoundedBox>& GetDamagedRegions(std::size_t richTextId);
+
+    struct LayoutCacheStats
+    {
+        std::size_t bytes = 0; // Approximate memory used by layouts
+        std::size_t evictions = 0;
+        std::size_t relayouts = 0; // Evicted layouts which were laid out again
+    };
+
+    // Once layouts use more than `budget` bytes (0 = unlimited), layouts of rich texts which were
+    // not shown in the last `idleFrames` frames are evicted, least recently shown first. The text 
+    // and its handle are retained, and the text is laid out again when shown next.
+    void SetLayoutMemoryBudget(std::size_t budget, int idleFrames = 60);
+    [[nodiscard]] LayoutCacheStats GetLayoutCacheStats();
+
+    struct ContainerStats
+    {
+        std::size_t count = 0; // Elements in use
+        std::size_t bytes = 0; // Allocated, including unused capacity
+        std::size_t slack = 0; // Allocated for unused capacity
+    };
+
+    struct RichTextMemoryStats
+    {
+        ContainerStats lines;
+        ContainerStats segments;
+        ContainerStats tokens;
+        ContainerStats styles;
+        ContainerStats tagDescriptors;
+        ContainerStats listItems;
+        ContainerStats backgroundBlocks[IM_RICHTEXT_MAXDEPTH];
+        ContainerStats backgroundMesh; // Vertices, colors and indices
+        ContainerStats indices; // Animated content and hit-testing
+        ContainerStats animation; // Per text animation, hover and damage state
+        ContainerStats source; // Owned copies of text
+        ContainerStats tape; // Recorded parse events and words, see RenderConfig::CacheSegmentation
+        std::size_t documents = 0;
+        std::size_t total = 0; // Bytes of all of the above
+    };
+
+    // Memory used by the layout and state of a rich text, or of all rich texts (where shared 
+    // layouts are counted once).
+    [[nodiscard]] RichTextMemoryStats GetRichTextMemoryStats(std::size_t richTextId);
+    [[nodiscard]] RichTextMemoryStats GetRichTextMemoryStats();
+
+#ifdef IM_RICHTEXT_ENABLE_PROFILING
+    enum class ProfilePhase
+    {
+        Parse, Segmentation, Measurement, WordWrap, Geometry, Finalize, Draw, Total
+    };
+
+    struct PhaseCounters
+    {
+        long long nanoseconds = 0; // Includes nested phases, i.e. measurement during word wrap
+        std::size_t calls = 0;
+        std::size_t bytes = 0; // Text processed
+    };
+
+    struct ProfileCounters
+    {
+        PhaseCounters phases[(int)ProfilePhase::Total];
+    };
+
+    // Invoked when a phase starts/ends, to forward zones to external profilers
+    struct ProfilerHooks
+    {
+        void (*BeginZone)(ProfilePhase phase, std::size_t richTextId, void* userData) = nullptr;
+        void (*EndZone)(ProfilePhase phase, std::size_t richTextId, void* userData) = nullptr;
+        void* UserData = nullptr;
+    };
+
+    void SetProfilerHooks(const ProfilerHooks& hooks);
+    [[nodiscard]] const char* GetProfilePhaseName(ProfilePhase phase);
+
+    // Counters accumulated for a rich text since it was created, and for the last complete frame
+    [[nodiscard]] const ProfileCounters& GetProfileCounters(std::size_t richTextId);
+    [[nodiscard]] const ProfileCounters& GetFrameProfileCounters();
+
+    // Records parse, word wrap (per line), geometry, finalization and draw spans as Chrome trace
+    // events (for chrome://tracing or Perfetto), with the number of text measurements made in each.
+    // Events are buffered in lock-free per-thread rings of `eventsPerThread` events (dropping events
+    // when full), and appended to the file at `path` by FlushTrace() and StopTrace().
+    bool StartTrace(const char* path, std::size_t eventsPerThread = 65536);
+    void FlushTrace();
+    void StopTrace();
+
+    // Times the enclosing scope as a phase, for the rich text being laid out or drawn
+    struct ProfileScope
+    {
+        ProfilePhase phase;
+        std::size_t bytes = 0;
+        int line = -1; // Line being wrapped, if any
+        std::size_t measurements = 0; // Measurement count of this thread at start, for traces
+        std::chrono::steady_clock::time_point start;
+
+        ProfileScope(ProfilePhase phase, std::size_t bytes);
+        ~ProfileScope();
+    };
+
+#define IM_RICHTEXT_PROFILE_SCOPE(PHASE, BYTES) ImRichText::ProfileScope _profileScope{ ImRichText::ProfilePhase::PHASE, (std::size_t)(BYTES) }
+#define IM_RICHTEXT_PROFILE_BYTES(BYTES) _profileScope.bytes = (std::size_t)(BYTES)
+#define IM_RICHTEXT_PROFILE_LINE(LINE) _profileScope.line = (LINE)
+#else
+#define IM_RICHTEXT_PROFILE_SCOPE(PHASE, BYTES)
+#define IM_RICHTEXT_PROFILE_BYTES(BYTES)
+#define IM_RICHTEXT_PROFILE_LINE(LINE)
+#endif
+
 #ifdef IM_RICHTEXT_TARGET_IMGUI
     [[nodiscard]] ImVec2 GetBounds(std::size_t richTextId);
     bool Show(ImVec2 pos, std::size_t richTextId, std::optional<ImVec2> sz = std::nullopt);
     bool Show(std::size_t richTextId, std::optional<ImVec2> sz = std::nullopt);
     bool ToggleOverlay();
+
+    // Computes the size of rich text laid out within `width` (no wrapping if <= 0), with the
+    // current config. The layout is built into per-thread scratch storage, without background
+    // meshes, animations or the hit-test index. If `width` is specified, tokens and segments of
+    // lines are released once their geometry is final. No drawables are retained, and nothing
+    // is drawn.
+    [[nodiscard]] ImVec2 MeasureRichText(const char* text, float width = 0.f, const char* end = nullptr);
+
+    // Virtualized list of rich text items, shown in the current window (use a child window to get
+    // a scrollable region). Only visible items are laid out and kept alive, other items use their
+    // last measured height, or an estimate if they were never visible. Item text is not copied.
+    class RichTextList
+    {
+    public:
+
+        explicit RichTextList(float estimatedHeight = 0.f);
+        ~RichTextList();
+
+        RichTextList(const RichTextList&) = delete;
+        RichTextList& operator=(const RichTextList&) = delete;
+
+        int Add(const char* text, const char* end = nullptr);
+        void Set(int index, const char* text, const char* end = nullptr);
+        void Clear();
+        void Show();
+
+        [[nodiscard]] int Size() const { return (int)_items.size(); }
+        [[nodiscard]] float TotalHeight() const { return (float)Prefix((int)_items.size()); }
+        [[nodiscard]] int ItemAt(float offset) const;
+        [[nodiscard]] float ItemOffset(int index) const { return (float)Prefix(index); }
+
+    private:
+
+        struct Item
+        {
+            std::string_view text;
+            std::size_t id = 0;
+            float height = 0.f;
+        };
+
+        std::vector<Item> _items;
+        std::vector<double> _tree; // Fenwick tree of item heights, for offset <-> index mapping
+        std::vector<int> _visible;
+        float _estimatedHeight = 0.f;
+
+        double Prefix(int count) const;
+        void UpdateHeight(int index, float height);
+        void Release(Item& item);
+    };
+
 #endif
 #ifdef IM_RICHTEXT_TARGET_BLEND2D
     [[nodiscard]] ImVec2 GetBounds(BLContext& context, std::size_t richTextId);
     bool Show(BLContext& context, ImVec2 pos, std::size_t richTextId, std::optional<ImVec2> sz = std::nullopt);
+    [[nodiscard]] ImVec2 MeasureRichText(BLContext& context, const char* text, float width = 0.f, 
+        const char* end = nullptr);
+
+    // Marks the start of a frame, to find rich texts which were not shown recently (ImGui frames are 
+    // tracked automatically)
+    void NewFrame();
 #endif
+
+    // Renders on the CPU into a width x height buffer (same color layout as the target) with
+    // the provided config, the glyph source of the target is used if none is provided. No
+    // window, frame, rendering backend or current target context is required.
+    [[nodiscard]] std::vector<uint32_t> RenderToBuffer(std::size_t richTextId, int width, int height, 
+        const RenderConfig& config, IGlyphSource* glyphs = nullptr);
 }
@@ -137,8 +137,41 @@ namespace ImFontManager
         }
     };
 
-    static std::unordered_map<std::string_view, FontFamily> FontStore;
-    static FontLookupInfo FontLookup;
+    struct FontContext
+    {
+        std::unordered_map<std::string_view, FontFamily> FontStore;
+        FontLookupInfo FontLookup;
+    };
+
+    static FontContext DefaultFontContext;
+    static thread_local FontContext* CurrentFontContext = nullptr;
+
+    static FontContext& GetFontContext()
+    {
+        return CurrentFontContext != nullptr ? *CurrentFontContext : DefaultFontContext;
+    }
+
+    FontContext* CreateFontContext()
+    {
+        return new FontContext{};
+    }
+
+    void DestroyFontContext(FontContext* context)
+    {
+        if (context == nullptr || context == &DefaultFontContext) return;
+        if (CurrentFontContext == context) CurrentFontContext = nullptr;
+        delete context;
+    }
+
+    void SetCurrentFontContext(FontContext* context)
+    {
+        CurrentFontContext = context;
+    }
+
+    FontContext* GetCurrentFontContext()
+    {
+        return &GetFontContext();
+    }
 
 #ifdef IM_RICHTEXT_TARGET_IMGUI
     static void LoadFont(ImGuiIO& io, FontFamily& family, FontType ft, float size, ImFontConfig config, int flag)
@@ -174,9 +207,8 @@ namespace ImFontManager
     bool LoadFonts(std::string_view family, const FontCollectionFile& files, float size, ImFontConfig config, bool autoScale)
     {
         ImGuiIO& io = ImGui::GetIO();
-        FontStore[family].Files = files;
-
-        auto& ffamily = FontStore[family];
+        auto& ffamily = GetFontContext().FontStore[family];
+        ffamily.Files = files;
         ffamily.AutoScale = autoScale;
         LoadFont(io, ffamily, FT_Normal, size, config, 0);
 
@@ -225,7 +257,7 @@ namespace ImFontManager
 
     bool LoadFonts(std::string_view family, const FontCollectionFile& files, float size)
     {
-        auto& ffamily = FontStore[family];
+        auto& ffamily = GetFontContext().FontStore[family];
         ffamily.Files = files;
         CreateFont(ffamily, FT_Normal, size);
         CreateFont(ffamily, FT_Light, size);
@@ -787,7 +819,7 @@ namespace ImFontManager
                     auto ft = isBold && isItalics ? FT_BoldItalics : isBold ? FT_Bold :
                         isItalics ? FT_Italics : FT_Normal;
                     auto isSerif = info.fontName.find("Serif") != std::string::npos;
-                    FontLookup.Register(info.fontName, info.filename, ft, isMonospaced, isSerif);
+                    GetFontContext().FontLookup.Register(info.fontName, info.filename, ft, isMonospaced, isSerif);
                 }
             }
 
@@ -829,7 +861,7 @@ namespace ImFontManager
                     auto ftype = isBold && info.isItalic ? FT_BoldItalics :
                         isBold ? FT_Bold : info.isItalic ? FT_Italics :
                         (info.weight < 400) || info.isLight ? FT_Light : FT_Normal;
-                    FontLookup.Register(info.fontFamily, fpath, ftype, info.isMono, info.isSerif);
+                    GetFontContext().FontLookup.Register(info.fontFamily, fpath, ftype, info.isMono, info.isSerif);
                     break;
                 }
             }
@@ -840,7 +872,7 @@ namespace ImFontManager
             auto ftype = isBold && info.isItalic ? FT_BoldItalics :
                 isBold ? FT_Bold : info.isItalic ? FT_Italics :
                 (info.weight < 400) || info.isLight ? FT_Light : FT_Normal;
-            FontLookup.Register(info.fontFamily, fpath, ftype, info.isMono, info.isSerif);
+            GetFontContext().FontLookup.Register(info.fontFamily, fpath, ftype, info.isMono, info.isSerif);
         }
     }
 
@@ -852,7 +884,7 @@ namespace ImFontManager
         
         for (auto idx = 0; idx < lookupSz; ++idx)
         {
-            if (FontLookup.LookupPaths.count(lookupPaths[idx]) == 0)
+            if (GetFontContext().FontLookup.LookupPaths.count(lookupPaths[idx]) == 0)
                 notLookedUp.insert(lookupPaths[idx]);
         }
 
@@ -926,38 +958,40 @@ namespace ImFontManager
     std::string_view FindFontFile(std::string_view family, FontType ft, std::string_view* lookupPaths, int lookupSz)
     {
         PreloadFontLookupInfoImpl(-1, lookupPaths, lookupSz);
-        auto it = FontLookup.ProportionalFontFamilies.find(family);
+        auto& lookup = GetFontContext().FontLookup;
+        auto it = lookup.ProportionalFontFamilies.find(family);
 
-        if (it == FontLookup.ProportionalFontFamilies.end())
+        if (it == lookup.ProportionalFontFamilies.end())
         {
-            it = FontLookup.MonospaceFontFamilies.find(family);
+            it = lookup.MonospaceFontFamilies.find(family);
 
-            if (it == FontLookup.MonospaceFontFamilies.end())
+            if (it == lookup.MonospaceFontFamilies.end())
             {
                 auto isDefaultMonospace = family.find("monospace") != std::string_view::npos;
                 auto isDefaultSerif = family.find("serif") != std::string_view::npos &&
                     family.find("sans") == std::string_view::npos;
 
 #ifdef _WIN32
-                it = isDefaultMonospace ? FontLookup.MonospaceFontFamilies.find("Consolas") :
-                    isDefaultSerif ? FontLookup.ProportionalFontFamilies.find("Times New Roman") :
-                    FontLookup.ProportionalFontFamilies.find("Segoe UI");
+                it = isDefaultMonospace ? lookup.MonospaceFontFamilies.find("Consolas") :
+                    isDefaultSerif ? lookup.ProportionalFontFamilies.find("Times New Roman") :
+                    lookup.ProportionalFontFamilies.find("Segoe UI");
 #endif
                 // TODO: Implement for Linux
             }
         }
         
-        return FontLookup.info[it->second].files[ft];
+        return lookup.info[it->second].files[ft];
     }
 
 #ifdef IM_RICHTEXT_TARGET_IMGUI
     static auto LookupFontFamily(std::string_view family)
     {
-        auto famit = FontStore.find(family);
+        auto& store = GetFontContext().FontStore;
+        auto famit = store.find(family);
 
-        if (famit == FontStore.end())
+        if (famit == store.end())
         {
-            for (auto it = FontStore.begin(); it != FontStore.end(); ++it)
+            for (auto it = store.begin(); it != store.end(); ++it)
             {
                 if (it->first.find(family) == 0u ||
                     family.find(it->first) == 0u)
@@ -967,8 +1001,8 @@ namespace ImFontManager
             }
         }
 
-        if (famit == FontStore.end())
-            famit = FontStore.find(IM_RICHTEXT_DEFAULT_FONTFAMILY);
+        if (famit == store.end())
+            famit = store.find(IM_RICHTEXT_DEFAULT_FONTFAMILY);
 
         return famit;
     }
@@ -1018,9 +1052,10 @@ namespace ImFontManager
 
     void* GetFont(std::string_view family, float size, FontType type, FontExtraInfo extra)
     {
-        auto famit = FontStore.find(family);
+        auto& store = GetFontContext().FontStore;
+        auto famit = store.find(family);
 
-        if (famit != FontStore.end())
+        if (famit != store.end())
         {
             if (famit->second.Fonts[ft])
             {
@@ -1032,14 +1067,14 @@ namespace ImFontManager
         }
         else
         {
-            auto& ffamily = FontStore[family];
+            auto& ffamily = store[family];
             ffamily.Files[ft] = extra.mapper != nullptr ? extra.mapper(family) : 
                 extra.filepath.empty() ? FindFontFile(family, type) : extra.filepath;
             assert(!ffamily.Files[ft].empty());
             CreateFont(ffamily, ft, sz);
         }
 
-        return &(FontStore.at(family).Fonts[ft].at(size));
+        return &(store.at(family).Fonts[ft].at(size));
     }
 #endif
 }
\ No newline at end of file
@@ -52,6 +52,15 @@ namespace ImFontManager
 
     struct RenderConfig;
 
+    // Loaded fonts and font lookup info. Threads use a process-wide default until they set their
+    // own, e.g. for separate font atlases per ImGui context or separate Blend2D fonts per thread.
+    struct FontContext;
+
+    [[nodiscard]] FontContext* CreateFontContext();
+    void DestroyFontContext(FontContext* context);
+    void SetCurrentFontContext(FontContext* context); // Selects the default if nullptr
+    [[nodiscard]] FontContext* GetCurrentFontContext();
+
     enum FontLoadType : uint64_t
     {
         FLT_Proportional = 1,
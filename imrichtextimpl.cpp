@@ -5,6 +5,14 @@
 #include "imrichtext.h"
 
 #include <cctype>
+#include <cmath>
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define IM_RICHTEXT_SOFTWARE_SSE2
+#endif
 
 namespace ImRichText
 {
@@ -422,542 +430,2284 @@ namespace ImRichText
         { "deg", u8"°" }, { "micro", u8"μ" }, { "trade", u8"™" }
     };
 
-#ifdef IM_RICHTEXT_TARGET_IMGUI
-
-    ImGuiRenderer::ImGuiRenderer(RenderConfig& cfg)
-        : config{ cfg } {}
-
-    void ImGuiRenderer::SetClipRect(ImVec2 startpos, ImVec2 endpos)
-    {
-        ImGui::PushClipRect(startpos, endpos, true);
-    }
-
-    void ImGuiRenderer::ResetClipRect()
-    {
-        ImGui::PopClipRect();
-    }
-
-    void ImGuiRenderer::DrawLine(ImVec2 startpos, ImVec2 endpos, uint32_t color, float thickness)
+    static uint32_t LerpColor(uint32_t from, uint32_t to, float t)
     {
-        ((ImDrawList*)UserData)->AddLine(startpos, endpos, color, thickness);
-    }
+        uint32_t result = 0;
 
-    void ImGuiRenderer::DrawPolyline(ImVec2* points, int sz, uint32_t color, float thickness)
-    {
-        ((ImDrawList*)UserData)->AddPolyline(points, sz, color, 0, thickness);
-    }
+        for (auto shift = 0; shift < 32; shift += 8)
+        {
+            auto a = (float)((from >> shift) & 0xFF), b = (float)((to >> shift) & 0xFF);
+            result |= ((uint32_t)(a + (b - a) * t + 0.5f) & 0xFF) << shift;
+        }
 
-    void ImGuiRenderer::DrawTriangle(ImVec2 pos1, ImVec2 pos2, ImVec2 pos3, uint32_t color, bool filled, bool thickness)
-    {
-        filled ? ((ImDrawList*)UserData)->AddTriangleFilled(pos1, pos2, pos3, color) :
-            ((ImDrawList*)UserData)->AddTriangle(pos1, pos2, pos3, color, thickness);
+        return result;
     }
 
-    void ImGuiRenderer::DrawRect(ImVec2 startpos, ImVec2 endpos, uint32_t color, bool filled, float thickness)
+    // Scale an averaged normal, so that offsetting along it keeps the edges at unit distance
+    static ImVec2 FixNormal(ImVec2 normal)
     {
-        if (thickness > 0.f || filled)
+        auto d2 = normal.x * normal.x + normal.y * normal.y;
+        if (d2 > 0.000001f)
         {
-            filled ? ((ImDrawList*)UserData)->AddRectFilled(startpos, endpos, color) :
-                ((ImDrawList*)UserData)->AddRect(startpos, endpos, color, 0.f, 0, thickness);
+            auto invlen2 = std::min(1.f / d2, 100.f);
+            normal.x *= invlen2;
+            normal.y *= invlen2;
         }
+        return normal;
     }
 
-    void ImGuiRenderer::DrawRoundedRect(ImVec2 startpos, ImVec2 endpos, uint32_t color, bool filled, 
-        float topleftr, float toprightr, float bottomrightr, float bottomleftr, float thickness)
+    static ImVec2 EdgeNormal(ImVec2 from, ImVec2 to)
     {
-        auto isUniformRadius = (topleftr == toprightr && toprightr == bottomrightr && bottomrightr == bottomleftr) ||
-            ((topleftr + toprightr + bottomrightr + bottomleftr) == 0.f);
-
-        if (isUniformRadius)
-        {
-            auto drawflags = 0;
-
-            if (topleftr > 0.f) drawflags |= ImDrawFlags_RoundCornersTopLeft;
-            if (toprightr > 0.f) drawflags |= ImDrawFlags_RoundCornersTopRight;
-            if (bottomrightr > 0.f) drawflags |= ImDrawFlags_RoundCornersBottomRight;
-            if (bottomleftr > 0.f) drawflags |= ImDrawFlags_RoundCornersBottomLeft;
-
-            filled ? ((ImDrawList*)UserData)->AddRectFilled(startpos, endpos, color, toprightr, drawflags) :
-                ((ImDrawList*)UserData)->AddRect(startpos, endpos, color, toprightr, drawflags, thickness);
-        }
-        else
+        auto dx = to.x - from.x, dy = to.y - from.y;
+        auto d2 = dx * dx + dy * dy;
+        if (d2 > 0.f)
         {
-            auto& dl = *((ImDrawList*)UserData);
-            auto minlength = std::min(endpos.x - startpos.x, endpos.y - startpos.y);
-            topleftr = std::min(topleftr, minlength);
-            toprightr = std::min(toprightr, minlength);
-            bottomrightr = std::min(bottomrightr, minlength);
-            bottomleftr = std::min(bottomleftr, minlength);
-
-            dl.PathClear();
-            dl.PathLineTo(ImVec2{ startpos.x, endpos.y - bottomleftr });
-            dl.PathLineTo(ImVec2{ startpos.x, startpos.y + topleftr });
-            if (topleftr > 0.f) dl.PathArcToFast(ImVec2{ startpos.x + topleftr, startpos.y + topleftr }, topleftr, 6, 9);
-            dl.PathLineTo(ImVec2{ endpos.x - toprightr, startpos.y });
-            if (toprightr > 0.f) dl.PathArcToFast(ImVec2{ endpos.x - toprightr, startpos.y + toprightr }, toprightr, 9, 12);
-            dl.PathLineTo(ImVec2{ endpos.x, endpos.y - bottomrightr });
-            if (bottomrightr > 0.f) dl.PathArcToFast(ImVec2{ endpos.x - bottomrightr, endpos.y - bottomrightr }, bottomrightr, 0, 3);
-            dl.PathLineTo(ImVec2{ startpos.x - bottomleftr, endpos.y });
-            if (bottomleftr > 0.f) dl.PathArcToFast(ImVec2{ startpos.x + bottomleftr, endpos.y - bottomleftr }, bottomleftr, 3, 6);
-            
-            filled ? dl.PathFillConvex(color) : dl.PathStroke(color, 0, thickness);
+            auto invlen = 1.f / std::sqrt(d2);
+            dx *= invlen;
+            dy *= invlen;
         }
+        return ImVec2{ dy, -dx };
     }
 
-    void ImGuiRenderer::DrawRectGradient(ImVec2 startpos, ImVec2 endpos, uint32_t topleftcolor, uint32_t toprightcolor, uint32_t bottomrightcolor, uint32_t bottomleftcolor)
-    {
-        ((ImDrawList*)UserData)->AddRectFilledMultiColor(startpos, endpos, topleftcolor, toprightcolor, bottomrightcolor, bottomleftcolor);
-    }
+    MeshRecorder::MeshRecorder(MeshData& target)
+        : mesh{ target }
+    {}
 
-    void ImGuiRenderer::DrawCircle(ImVec2 center, float radius, uint32_t color, bool filled, bool thickness)
+    void MeshRecorder::SetClipRect(ImVec2 startpos, ImVec2 endpos)
     {
-        filled ? ((ImDrawList*)UserData)->AddCircleFilled(center, radius, color) :
-            ((ImDrawList*)UserData)->AddCircle(center, radius, color, 0, thickness);
+        _clipMin = startpos;
+        _clipMax = endpos;
+        _clipped = true;
     }
 
-    void ImGuiRenderer::DrawPolygon(ImVec2* points, int sz, uint32_t color, bool filled, float thickness)
+    void MeshRecorder::ResetClipRect()
     {
-        filled ? ((ImDrawList*)UserData)->AddConvexPolyFilled(points, sz, color) :
-            ((ImDrawList*)UserData)->AddPolyline(points, sz, color, ImDrawFlags_Closed, thickness);
+        _clipped = false;
     }
 
-    void ImGuiRenderer::DrawPolyGradient(ImVec2* points, uint32_t* colors, int sz)
+    void MeshRecorder::AddTriangles(const ImVec2* positions, const uint32_t* colors, int vtxcount,
+        const uint32_t* indices, int idxcount, ImVec2 offset)
     {
-        auto drawList = ((ImDrawList*)UserData);
-        const ImVec2 uv = drawList->_Data->TexUvWhitePixel;
-
-        if (drawList->Flags & ImDrawListFlags_AntiAliasedFill)
+        if (!_clipped)
         {
-            // Anti-aliased Fill
-            const float AA_SIZE = 1.0f;
-            const int idx_count = (sz - 2) * 3 + sz * 6;
-            const int vtx_count = (sz * 2);
-            drawList->PrimReserve(idx_count, vtx_count);
-
-            // Add indexes for fill
-            unsigned int vtx_inner_idx = drawList->_VtxCurrentIdx;
-            unsigned int vtx_outer_idx = drawList->_VtxCurrentIdx + 1;
-            for (int i = 2; i < sz; i++)
+            auto base = (uint32_t)mesh.positions.size();
+            for (auto idx = 0; idx < vtxcount; ++idx)
             {
-                drawList->_IdxWritePtr[0] = (ImDrawIdx)(vtx_inner_idx);
-                drawList->_IdxWritePtr[1] = (ImDrawIdx)(vtx_inner_idx + ((i - 1) << 1));
-                drawList->_IdxWritePtr[2] = (ImDrawIdx)(vtx_inner_idx + (i << 1));
-                drawList->_IdxWritePtr += 3;
+                mesh.positions.push_back(positions[idx] + offset);
+                mesh.colors.push_back(colors[idx]);
             }
+            for (auto idx = 0; idx < idxcount; ++idx)
+                mesh.indices.push_back(base + indices[idx]);
+            return;
+        }
 
-            // Compute normals
-            ImVec2* temp_normals = (ImVec2*)alloca(sz * sizeof(ImVec2));
-            for (int i0 = sz - 1, i1 = 0; i1 < sz; i0 = i1++)
+        // Clip each triangle against the four sides of the clip rect, which adds
+        // at most one vertex per side (Sutherland-Hodgman)
+        ImVec2 points[2][8];
+        uint32_t pointcolors[2][8];
+
+        for (auto idx = 0; idx + 2 < idxcount; idx += 3)
+        {
+            auto count = 3, curr = 0;
+            for (auto vtx = 0; vtx < 3; ++vtx)
             {
-                const ImVec2& p0 = points[i0];
-                const ImVec2& p1 = points[i1];
-                ImVec2 diff = p1 - p0;
-                diff *= ImInvLength(diff, 1.0f);
-                temp_normals[i0].x = diff.y;
-                temp_normals[i0].y = -diff.x;
+                points[0][vtx] = positions[indices[idx + vtx]] + offset;
+                pointcolors[0][vtx] = colors[indices[idx + vtx]];
             }
 
-            for (int i0 = sz - 1, i1 = 0; i1 < sz; i0 = i1++)
+            for (auto side = 0; side < 4 && count >= 3; ++side)
             {
-                // Average normals
-                const ImVec2& n0 = temp_normals[i0];
-                const ImVec2& n1 = temp_normals[i1];
-                ImVec2 dm = (n0 + n1) * 0.5f;
-                float dmr2 = dm.x * dm.x + dm.y * dm.y;
-                if (dmr2 > 0.000001f)
+                auto distance = [&](ImVec2 pt) {
+                    switch (side)
+                    {
+                    case 0: return pt.x - _clipMin.x;
+                    case 1: return pt.y - _clipMin.y;
+                    case 2: return _clipMax.x - pt.x;
+                    default: return _clipMax.y - pt.y;
+                    }
+                };
+
+                auto next = 0;
+                for (auto vtx = 0; vtx < count; ++vtx)
                 {
-                    float scale = 1.0f / dmr2;
-                    if (scale > 100.0f) scale = 100.0f;
-                    dm *= scale;
-                }
-                dm *= AA_SIZE * 0.5f;
+                    auto nextvtx = (vtx + 1) % count;
+                    auto from = distance(points[curr][vtx]), to = distance(points[curr][nextvtx]);
 
-                // Add vertices
-                drawList->_VtxWritePtr[0].pos = (points[i1] - dm);
-                drawList->_VtxWritePtr[0].uv = uv; drawList->_VtxWritePtr[0].col = colors[i1];        // Inner
-                drawList->_VtxWritePtr[1].pos = (points[i1] + dm);
-                drawList->_VtxWritePtr[1].uv = uv; drawList->_VtxWritePtr[1].col = colors[i1] & ~IM_COL32_A_MASK;  // Outer
-                drawList->_VtxWritePtr += 2;
+                    if (from >= 0.f)
+                    {
+                        points[1 - curr][next] = points[curr][vtx];
+                        pointcolors[1 - curr][next++] = pointcolors[curr][vtx];
+                    }
 
-                // Add indexes for fringes
-                drawList->_IdxWritePtr[0] = (ImDrawIdx)(vtx_inner_idx + (i1 << 1));
-                drawList->_IdxWritePtr[1] = (ImDrawIdx)(vtx_inner_idx + (i0 << 1));
-                drawList->_IdxWritePtr[2] = (ImDrawIdx)(vtx_outer_idx + (i0 << 1));
-                drawList->_IdxWritePtr[3] = (ImDrawIdx)(vtx_outer_idx + (i0 << 1));
-                drawList->_IdxWritePtr[4] = (ImDrawIdx)(vtx_outer_idx + (i1 << 1));
-                drawList->_IdxWritePtr[5] = (ImDrawIdx)(vtx_inner_idx + (i1 << 1));
-                drawList->_IdxWritePtr += 6;
+                    if ((from >= 0.f) != (to >= 0.f))
+                    {
+                        auto t = from / (from - to);
+                        points[1 - curr][next] = points[curr][vtx] + (points[curr][nextvtx] - points[curr][vtx]) * t;
+                        pointcolors[1 - curr][next++] = LerpColor(pointcolors[curr][vtx], pointcolors[curr][nextvtx], t);
+                    }
+                }
+
+                count = next;
+                curr = 1 - curr;
             }
 
-            drawList->_VtxCurrentIdx += (ImDrawIdx)vtx_count;
-        }
-        else
-        {
-            // Non Anti-aliased Fill
-            const int idx_count = (sz - 2) * 3;
-            const int vtx_count = sz;
-            drawList->PrimReserve(idx_count, vtx_count);
-            for (int i = 0; i < vtx_count; i++)
+            if (count < 3) continue;
+
+            auto base = (uint32_t)mesh.positions.size();
+            for (auto vtx = 0; vtx < count; ++vtx)
             {
-                drawList->_VtxWritePtr[0].pos = points[i];
-                drawList->_VtxWritePtr[0].uv = uv;
-                drawList->_VtxWritePtr[0].col = colors[i];
-                drawList->_VtxWritePtr++;
+                mesh.positions.push_back(points[curr][vtx]);
+                mesh.colors.push_back(pointcolors[curr][vtx]);
             }
-            for (int i = 2; i < sz; i++)
+            for (auto vtx = 2; vtx < count; ++vtx)
             {
-                drawList->_IdxWritePtr[0] = (ImDrawIdx)(drawList->_VtxCurrentIdx);
-                drawList->_IdxWritePtr[1] = (ImDrawIdx)(drawList->_VtxCurrentIdx + i - 1);
-                drawList->_IdxWritePtr[2] = (ImDrawIdx)(drawList->_VtxCurrentIdx + i);
-                drawList->_IdxWritePtr += 3;
+                mesh.indices.push_back(base);
+                mesh.indices.push_back(base + vtx - 1);
+                mesh.indices.push_back(base + vtx);
             }
-
-            drawList->_VtxCurrentIdx += (ImDrawIdx)vtx_count;
         }
     }
 
-    void ImGuiRenderer::DrawRadialGradient(ImVec2 center, float radius, uint32_t in, uint32_t out, int start, int end)
+    void MeshRecorder::AddConvexFill(const ImVec2* points, int sz, uint32_t color)
     {
-        auto drawList = ((ImDrawList*)UserData);
-        if (((in | out) & IM_COL32_A_MASK) == 0 || radius < 0.5f)
-            return;
-        auto startrad = ((float)M_PI / 180.f) * (float)start;
-        auto endrad = ((float)M_PI / 180.f) * (float)end;
+        if (sz < 3 || (color & IM_COL32_A_MASK) == 0) return;
 
-        // Use arc with 32 segment count
-        drawList->PathArcTo(center, radius, startrad, endrad, 32);
-        const int count = drawList->_Path.Size - 1;
+        // Inner vertices are inset by half a pixel, and a transparent fringe is added outside,
+        // similar to ImDrawList::AddConvexPolyFilled. Normals must point outwards irrespective
+        // of the winding of the points.
+        auto area = 0.f;
+        for (auto idx = 0, prev = sz - 1; idx < sz; prev = idx++)
+            area += points[prev].x * points[idx].y - points[idx].x * points[prev].y;
+        auto orientation = area < 0.f ? -0.5f : 0.5f;
+        auto transparent = color & ~IM_COL32_A_MASK;
 
-        unsigned int vtx_base = drawList->_VtxCurrentIdx;
-        drawList->PrimReserve(count * 3, count + 1);
+        _positions.clear(); _colors.clear(); _indices.clear();
 
-        // Submit vertices
-        const ImVec2 uv = drawList->_Data->TexUvWhitePixel;
-        drawList->PrimWriteVtx(center, uv, in);
-        for (int n = 0; n < count; n++)
-            drawList->PrimWriteVtx(drawList->_Path[n], uv, out);
+        for (auto idx = 0; idx < sz; ++idx)
+        {
+            auto prev = (idx + sz - 1) % sz, next = (idx + 1) % sz;
+            auto normal = FixNormal((EdgeNormal(points[prev], points[idx]) + EdgeNormal(points[idx], points[next])) * 0.5f);
+            _positions.push_back(points[idx] - normal * orientation);
+            _positions.push_back(points[idx] + normal * orientation);
+            _colors.push_back(color);
+            _colors.push_back(transparent);
+        }
 
-        // Submit a fan of triangles
-        for (int n = 0; n < count; n++)
+        for (auto idx = 2; idx < sz; ++idx)
         {
-            drawList->PrimWriteIdx((ImDrawIdx)(vtx_base));
-            drawList->PrimWriteIdx((ImDrawIdx)(vtx_base + 1 + n));
-            drawList->PrimWriteIdx((ImDrawIdx)(vtx_base + 1 + ((n + 1) % count)));
+            _indices.push_back(0);
+            _indices.push_back((uint32_t)(idx - 1) * 2);
+            _indices.push_back((uint32_t)idx * 2);
         }
 
-        drawList->_Path.Size = 0;
+        for (auto idx = 0, prev = sz - 1; idx < sz; prev = idx++)
+        {
+            _indices.push_back((uint32_t)idx * 2);
+            _indices.push_back((uint32_t)prev * 2);
+            _indices.push_back((uint32_t)prev * 2 + 1);
+            _indices.push_back((uint32_t)prev * 2 + 1);
+            _indices.push_back((uint32_t)idx * 2 + 1);
+            _indices.push_back((uint32_t)idx * 2);
+        }
+
+        AddTriangles(_positions.data(), _colors.data(), (int)_positions.size(),
+            _indices.data(), (int)_indices.size(), ImVec2{ 0.f, 0.f });
     }
 
-    bool ImGuiRenderer::SetCurrentFont(std::string_view family, float sz, FontType type)
+    void MeshRecorder::AddStroke(const ImVec2* points, int sz, uint32_t color, float thickness, bool closed)
     {
-        auto font = GetFont(family, sz, type);
+        if (sz < 2 || thickness <= 0.f || (color & IM_COL32_A_MASK) == 0) return;
 
-        if (font != nullptr) 
+        // Strokes thinner than a pixel fade out instead of getting thinner
+        if (thickness < 1.f)
         {
-            _currentFontSz = sz;
-            ImGui::PushFont((ImFont*)font); 
-            return true;
+            auto alpha = (float)((color & IM_COL32_A_MASK) >> IM_COL32_A_SHIFT) * thickness;
+            color = (color & ~IM_COL32_A_MASK) | ((uint32_t)alpha << IM_COL32_A_SHIFT);
+            thickness = 1.f;
         }
 
-        return false;
-    }
+        // Each point has four vertices across the stroke: transparent, opaque, opaque, transparent
+        auto halfinner = (thickness - 1.f) * 0.5f;
+        auto transparent = color & ~IM_COL32_A_MASK;
+        auto segments = closed ? sz : sz - 1;
 
-    bool ImGuiRenderer::SetCurrentFont(void* fontptr, float sz)
-    {
-        if (fontptr != nullptr) 
+        _positions.clear(); _colors.clear(); _indices.clear();
+
+        for (auto idx = 0; idx < sz; ++idx)
         {
-            _currentFontSz = sz;
-            ImGui::PushFont((ImFont*)fontptr); 
-            return true;
+            ImVec2 normal;
+            if (!closed && idx == 0) normal = EdgeNormal(points[0], points[1]);
+            else if (!closed && idx == sz - 1) normal = EdgeNormal(points[sz - 2], points[sz - 1]);
+            else normal = FixNormal((EdgeNormal(points[(idx + sz - 1) % sz], points[idx]) +
+                EdgeNormal(points[idx], points[(idx + 1) % sz])) * 0.5f);
+
+            _positions.push_back(points[idx] + normal * (halfinner + 1.f));
+            _positions.push_back(points[idx] + normal * halfinner);
+            _positions.push_back(points[idx] - normal * halfinner);
+            _positions.push_back(points[idx] - normal * (halfinner + 1.f));
+            _colors.push_back(transparent);
+            _colors.push_back(color);
+            _colors.push_back(color);
+            _colors.push_back(transparent);
         }
 
-        return false;
+        for (auto segment = 0; segment < segments; ++segment)
+        {
+            auto from = (uint32_t)segment * 4, to = (uint32_t)((segment + 1) % sz) * 4;
+
+            for (uint32_t strip = 0; strip < 3; ++strip)
+            {
+                _indices.push_back(from + strip);
+                _indices.push_back(to + strip);
+                _indices.push_back(to + strip + 1);
+                _indices.push_back(to + strip + 1);
+                _indices.push_back(from + strip + 1);
+                _indices.push_back(from + strip);
+            }
+        }
+
+        AddTriangles(_positions.data(), _colors.data(), (int)_positions.size(),
+            _indices.data(), (int)_indices.size(), ImVec2{ 0.f, 0.f });
     }
 
-    void ImGuiRenderer::ResetFont()
+    void MeshRecorder::AddArc(ImVec2 center, float radius, float startrad, float endrad, int segments)
     {
-        ImGui::PopFont();
+        for (auto idx = 0; idx <= segments; ++idx)
+        {
+            auto angle = startrad + (endrad - startrad) * ((float)idx / (float)segments);
+            _path.push_back(center + ImVec2{ std::cos(angle) * radius, std::sin(angle) * radius });
+        }
     }
 
-    ImVec2 ImGuiRenderer::GetTextSize(std::string_view text, void* fontptr, float sz)
+    static int ArcSegments(float radius)
     {
-        auto imfont = (ImFont*)fontptr;
-        ImGui::PushFont(imfont);
-        auto txtsz = ImGui::CalcTextSize(text.data(), text.data() + text.size());
-        ImGui::PopFont();
+        return std::min(std::max((int)(radius * 0.5f) + 4, 4), 16);
+    }
 
-        auto ratio = (sz / imfont->FontSize);
-        txtsz.x *= ratio;
-        txtsz.y *= ratio;
-        return txtsz;
+    void MeshRecorder::DrawLine(ImVec2 startpos, ImVec2 endpos, uint32_t color, float thickness)
+    {
+        // Same half pixel offset as ImDrawList::AddLine
+        ImVec2 points[2] = { startpos + ImVec2{ 0.5f, 0.5f }, endpos + ImVec2{ 0.5f, 0.5f } };
+        AddStroke(points, 2, color, thickness, false);
     }
 
-    void ImGuiRenderer::DrawText(std::string_view text, ImVec2 pos, uint32_t color)
+    void MeshRecorder::DrawPolyline(ImVec2* points, int sz, uint32_t color, float thickness)
     {
-        auto font = ImGui::GetFont();
-        ((ImDrawList*)UserData)->AddText(font, _currentFontSz, pos, color, text.data(), text.data() + text.size());
+        AddStroke(points, sz, color, thickness, false);
     }
 
-    void ImGuiRenderer::DrawText(std::string_view text, std::string_view family, ImVec2 pos, float sz, uint32_t color, FontType type)
+    void MeshRecorder::DrawTriangle(ImVec2 pos1, ImVec2 pos2, ImVec2 pos3, uint32_t color, bool filled, bool thickness)
     {
-        auto popFont = false;
-        auto font = GetFont(family, sz, type);
+        ImVec2 points[3] = { pos1, pos2, pos3 };
+        filled ? AddConvexFill(points, 3, color) : AddStroke(points, 3, color, 1.f, true);
+    }
 
-        if (font != nullptr) 
+    void MeshRecorder::DrawRect(ImVec2 startpos, ImVec2 endpos, uint32_t color, bool filled, float thickness)
+    {
+        if (filled)
         {
-            ImGui::PushFont((ImFont*)font); 
-            popFont = true;
+            ImVec2 points[4] = { startpos, ImVec2{ endpos.x, startpos.y }, endpos, ImVec2{ startpos.x, endpos.y } };
+            uint32_t colors[4] = { color, color, color, color };
+            uint32_t indices[6] = { 0, 1, 2, 0, 2, 3 };
+            if (color & IM_COL32_A_MASK) AddTriangles(points, colors, 4, indices, 6, ImVec2{ 0.f, 0.f });
+        }
+        else
+        {
+            // Same half pixel inset as ImDrawList::AddRect
+            startpos = startpos + ImVec2{ 0.5f, 0.5f };
+            endpos = endpos - ImVec2{ 0.5f, 0.5f };
+            ImVec2 points[4] = { startpos, ImVec2{ endpos.x, startpos.y }, endpos, ImVec2{ startpos.x, endpos.y } };
+            AddStroke(points, 4, color, thickness, true);
         }
-
-        ((ImDrawList*)UserData)->AddText((ImFont*)font, sz, pos, color, text.data(), text.data() + text.size());
-        if (popFont) ImGui::PopFont();
     }
 
-    void ImGuiRenderer::DrawTooltip(ImVec2 pos, std::string_view text)
+    void MeshRecorder::DrawRoundedRect(ImVec2 startpos, ImVec2 endpos, uint32_t color, bool filled, 
+        float topleftr, float toprightr, float bottomrightr, float bottomleftr, float thickness)
     {
-        if (!text.empty())
+        if (!filled)
         {
-            SetCurrentFont(config.DefaultFontFamily, config.DefaultFontSize, FT_Normal);
-            ImGui::SetTooltip("%.*s", (int)text.size(), text.data());
-            ResetFont();
+            startpos = startpos + ImVec2{ 0.5f, 0.5f };
+            endpos = endpos - ImVec2{ 0.5f, 0.5f };
         }
+
+        auto maxradius = std::max(std::min(endpos.x - startpos.x, endpos.y - startpos.y) * 0.5f, 0.f);
+        topleftr = std::min(topleftr, maxradius);
+        toprightr = std::min(toprightr, maxradius);
+        bottomrightr = std::min(bottomrightr, maxradius);
+        bottomleftr = std::min(bottomleftr, maxradius);
+
+        auto pi = (float)M_PI;
+        _path.clear();
+
+        if (topleftr > 0.f) AddArc(startpos + ImVec2{ topleftr, topleftr }, topleftr, pi, 1.5f * pi, ArcSegments(topleftr));
+        else _path.push_back(startpos);
+        if (toprightr > 0.f) AddArc(ImVec2{ endpos.x - toprightr, startpos.y + toprightr }, toprightr, 1.5f * pi, 2.f * pi, ArcSegments(toprightr));
+        else _path.push_back(ImVec2{ endpos.x, startpos.y });
+        if (bottomrightr > 0.f) AddArc(endpos - ImVec2{ bottomrightr, bottomrightr }, bottomrightr, 0.f, 0.5f * pi, ArcSegments(bottomrightr));
+        else _path.push_back(endpos);
+        if (bottomleftr > 0.f) AddArc(ImVec2{ startpos.x + bottomleftr, endpos.y - bottomleftr }, bottomleftr, 0.5f * pi, pi, ArcSegments(bottomleftr));
+        else _path.push_back(ImVec2{ startpos.x, endpos.y });
+
+        filled ? AddConvexFill(_path.data(), (int)_path.size(), color) :
+            AddStroke(_path.data(), (int)_path.size(), color, thickness, true);
+    }
+
+    void MeshRecorder::DrawRectGradient(ImVec2 startpos, ImVec2 endpos, uint32_t topleftcolor, uint32_t toprightcolor, uint32_t bottomrightcolor, uint32_t bottomleftcolor)
+    {
+        ImVec2 points[4] = { startpos, ImVec2{ endpos.x, startpos.y }, endpos, ImVec2{ startpos.x, endpos.y } };
+        uint32_t colors[4] = { topleftcolor, toprightcolor, bottomrightcolor, bottomleftcolor };
+        uint32_t indices[6] = { 0, 1, 2, 0, 2, 3 };
+        AddTriangles(points, colors, 4, indices, 6, ImVec2{ 0.f, 0.f });
+    }
+
+    void MeshRecorder::DrawPolygon(ImVec2* points, int sz, uint32_t color, bool filled, float thickness)
+    {
+        filled ? AddConvexFill(points, sz, color) : AddStroke(points, sz, color, thickness, true);
+    }
+
+    void MeshRecorder::DrawPolyGradient(ImVec2* points, uint32_t* colors, int sz)
+    {
+        _indices.clear();
+        for (auto idx = 2; idx < sz; ++idx)
+        {
+            _indices.push_back(0);
+            _indices.push_back((uint32_t)idx - 1);
+            _indices.push_back((uint32_t)idx);
+        }
+
+        AddTriangles(points, colors, sz, _indices.data(), (int)_indices.size(), ImVec2{ 0.f, 0.f });
+    }
+
+    void MeshRecorder::DrawCircle(ImVec2 center, float radius, uint32_t color, bool filled, bool thickness)
+    {
+        auto segments = std::min(std::max((int)radius + 8, 12), 64);
+        _path.clear();
+        AddArc(center, radius, 0.f, 2.f * (float)M_PI, segments);
+        _path.pop_back();
+
+        filled ? AddConvexFill(_path.data(), (int)_path.size(), color) :
+            AddStroke(_path.data(), (int)_path.size(), color, 1.f, true);
+    }
+
+    void MeshRecorder::DrawRadialGradient(ImVec2 center, float radius, uint32_t in, uint32_t out, int start, int end)
+    {
+        if (((in | out) & IM_COL32_A_MASK) == 0 || radius < 0.5f)
+            return;
+
+        _path.clear();
+        _path.push_back(center);
+        AddArc(center, radius, ((float)M_PI / 180.f) * (float)start, ((float)M_PI / 180.f) * (float)end, 32);
+
+        _colors.assign(_path.size(), out);
+        _colors[0] = in;
+        _indices.clear();
+
+        for (auto idx = 2; idx < (int)_path.size(); ++idx)
+        {
+            _indices.push_back(0);
+            _indices.push_back((uint32_t)idx - 1);
+            _indices.push_back((uint32_t)idx);
+        }
+
+        AddTriangles(_path.data(), _colors.data(), (int)_path.size(), _indices.data(), (int)_indices.size(), ImVec2{ 0.f, 0.f });
+    }
+
+    void MeshRecorder::DrawMesh(const ImVec2* positions, const uint32_t* colors, int vtxcount,
+        const uint32_t* indices, int idxcount, ImVec2 offset)
+    {
+        AddTriangles(positions, colors, vtxcount, indices, idxcount, offset);
+    }
+
+    ImVec2 MeshRecorder::GetTextSize(std::string_view text, void* fontptr, float sz)
+    {
+        return ImVec2{ 0.f, 0.f };
+    }
+
+    void MeshRecorder::DrawText(std::string_view text, ImVec2 pos, uint32_t color) {}
+    void MeshRecorder::DrawText(std::string_view text, std::string_view family, ImVec2 pos, float sz, uint32_t color, FontType type) {}
+    void MeshRecorder::DrawTooltip(ImVec2 pos, std::string_view text) {}
+
+    static int CountPatternDashes(float length, const LinePattern& pattern)
+    {
+        auto count = 0, segment = 0;
+
+        for (auto current = 0.f; current < length; segment = (segment + 1) % pattern.count)
+        {
+            if ((segment % 2) == 0) count++;
+            current += pattern.segments[segment];
+        }
+
+        return count;
+    }
+
+    TracingRenderer::TracingRenderer(IRenderer& target)
+        : renderer{ target }
+    {}
+
+    TracingRenderer::~TracingRenderer()
+    {
+        StopCapture();
+    }
+
+    const char* TracingRenderer::PrimitiveName(Primitive primitive)
+    {
+        static const char* Names[TP_Total] = {
+            "Line", "Polyline", "Triangle", "Rect", "RoundedRect", "RectGradient", "Polygon",
+            "PolyGradient", "Circle", "RadialGradient", "Bullet", "PatternLine", "PatternRect",
+            "Mesh", "Text", "Tooltip"
+        };
+        return primitive >= 0 && primitive < TP_Total ? Names[primitive] : "";
+    }
+
+    void TracingRenderer::NewFrame()
+    {
+        previous = current;
+        current = FrameStats{};
+        _lastFamily.clear();
+        _lastFontPtr = nullptr;
+        _lastFontSize = -1.f;
+        _lastFontType = FT_Total;
+        ++frame;
+        Log("# frame %d\n", frame);
+    }
+
+    bool TracingRenderer::StartCapture(const char* path)
+    {
+        StopCapture();
+        _capture = std::fopen(path, "w");
+        if (_capture != nullptr) Log("# frame %d\n", frame);
+        return _capture != nullptr;
+    }
+
+    void TracingRenderer::StopCapture()
+    {
+        if (_capture != nullptr)
+        {
+            std::fclose(_capture);
+            _capture = nullptr;
+        }
+    }
+
+    IRenderer& TracingRenderer::Record(Primitive primitive, std::size_t vertices)
+    {
+        current.primitives[primitive]++;
+        current.estimatedVertices += vertices;
+        Log("%s", PrimitiveName(primitive));
+
+        // Draw target (e.g. ImDrawList*) is assigned to the outermost renderer
+        renderer.UserData = UserData;
+        return renderer;
+    }
+
+    // Number of points ImDrawList uses for a full circle of given radius (approximately)
+    static std::size_t CirclePoints(float radius)
+    {
+        return (std::size_t)std::min(std::max((int)radius + 12, 12), 64);
+    }
+
+    void TracingRenderer::SetClipRect(ImVec2 startpos, ImVec2 endpos)
+    {
+        current.clipRects++;
+        Log("SetClipRect %.1f %.1f %.1f %.1f\n", startpos.x, startpos.y, endpos.x, endpos.y);
+        renderer.UserData = UserData;
+        renderer.SetClipRect(startpos, endpos);
+    }
+
+    void TracingRenderer::ResetClipRect()
+    {
+        Log("ResetClipRect\n");
+        renderer.ResetClipRect();
+    }
+
+    void TracingRenderer::DrawLine(ImVec2 startpos, ImVec2 endpos, uint32_t color, float thickness)
+    {
+        auto& target = Record(TP_Line, 8);
+        Log(" %.1f %.1f %.1f %.1f %08x %.1f\n", startpos.x, startpos.y, endpos.x, endpos.y, color, thickness);
+        target.DrawLine(startpos, endpos, color, thickness);
+    }
+
+    void TracingRenderer::DrawPolyline(ImVec2* points, int sz, uint32_t color, float thickness)
+    {
+        auto& target = Record(TP_Polyline, (std::size_t)sz * 4u);
+        Log(" %d %08x %.1f\n", sz, color, thickness);
+        target.DrawPolyline(points, sz, color, thickness);
+    }
+
+    void TracingRenderer::DrawTriangle(ImVec2 pos1, ImVec2 pos2, ImVec2 pos3, uint32_t color, bool filled, bool thickness)
+    {
+        auto& target = Record(TP_Triangle, filled ? 6 : 12);
+        Log(" %.1f %.1f %.1f %.1f %.1f %.1f %08x %d\n", pos1.x, pos1.y, pos2.x, pos2.y, pos3.x, pos3.y, color, (int)filled);
+        target.DrawTriangle(pos1, pos2, pos3, color, filled, thickness);
+    }
+
+    void TracingRenderer::DrawRect(ImVec2 startpos, ImVec2 endpos, uint32_t color, bool filled, float thickness)
+    {
+        auto& target = Record(TP_Rect, filled ? 4 : 16);
+        Log(" %.1f %.1f %.1f %.1f %08x %d %.1f\n", startpos.x, startpos.y, endpos.x, endpos.y, color, (int)filled, thickness);
+        target.DrawRect(startpos, endpos, color, filled, thickness);
+    }
+
+    void TracingRenderer::DrawRoundedRect(ImVec2 startpos, ImVec2 endpos, uint32_t color, bool filled, 
+        float topleftr, float toprightr, float bottomrightr, float bottomleftr, float thickness)
+    {
+        auto points = (CirclePoints(topleftr) + CirclePoints(toprightr) + CirclePoints(bottomrightr) + CirclePoints(bottomleftr)) / 4u;
+        auto& target = Record(TP_RoundedRect, points * (filled ? 2u : 4u));
+        Log(" %.1f %.1f %.1f %.1f %08x %d %.1f %.1f %.1f %.1f %.1f\n", startpos.x, startpos.y, endpos.x, endpos.y, color, 
+            (int)filled, topleftr, toprightr, bottomrightr, bottomleftr, thickness);
+        target.DrawRoundedRect(startpos, endpos, color, filled, topleftr, toprightr, bottomrightr, bottomleftr, thickness);
+    }
+
+    void TracingRenderer::DrawRectGradient(ImVec2 startpos, ImVec2 endpos, uint32_t topleftcolor, uint32_t toprightcolor, uint32_t bottomrightcolor, uint32_t bottomleftcolor)
+    {
+        auto& target = Record(TP_RectGradient, 4);
+        Log(" %.1f %.1f %.1f %.1f %08x %08x %08x %08x\n", startpos.x, startpos.y, endpos.x, endpos.y, 
+            topleftcolor, toprightcolor, bottomrightcolor, bottomleftcolor);
+        target.DrawRectGradient(startpos, endpos, topleftcolor, toprightcolor, bottomrightcolor, bottomleftcolor);
+    }
+
+    void TracingRenderer::DrawPolygon(ImVec2* points, int sz, uint32_t color, bool filled, float thickness)
+    {
+        auto& target = Record(TP_Polygon, (std::size_t)sz * (filled ? 2u : 4u));
+        Log(" %d %08x %d %.1f\n", sz, color, (int)filled, thickness);
+        target.DrawPolygon(points, sz, color, filled, thickness);
+    }
+
+    void TracingRenderer::DrawPolyGradient(ImVec2* points, uint32_t* colors, int sz)
+    {
+        auto& target = Record(TP_PolyGradient, (std::size_t)sz * 2u);
+        Log(" %d\n", sz);
+        target.DrawPolyGradient(points, colors, sz);
+    }
+
+    void TracingRenderer::DrawCircle(ImVec2 center, float radius, uint32_t color, bool filled, bool thickness)
+    {
+        auto& target = Record(TP_Circle, CirclePoints(radius) * (filled ? 2u : 4u));
+        Log(" %.1f %.1f %.1f %08x %d\n", center.x, center.y, radius, color, (int)filled);
+        target.DrawCircle(center, radius, color, filled, thickness);
+    }
+
+    void TracingRenderer::DrawRadialGradient(ImVec2 center, float radius, uint32_t in, uint32_t out, int start, int end)
+    {
+        auto& target = Record(TP_RadialGradient, 33);
+        Log(" %.1f %.1f %.1f %08x %08x %d %d\n", center.x, center.y, radius, in, out, start, end);
+        target.DrawRadialGradient(center, radius, in, out, start, end);
+    }
+
+    void TracingRenderer::DrawBullet(ImVec2 startpos, ImVec2 endpos, uint32_t color, int index, int depth)
+    {
+        auto& target = Record(TP_Bullet, 0);
+        Log(" %.1f %.1f %.1f %.1f %08x %d %d\n", startpos.x, startpos.y, endpos.x, endpos.y, color, index, depth);
+        target.DrawBullet(startpos, endpos, color, index, depth);
+    }
+
+    void TracingRenderer::DrawPatternLine(ImVec2 startpos, ImVec2 endpos, uint32_t color, LineType type, float thickness)
+    {
+        auto pattern = GetLinePattern(type, thickness);
+        auto diff = endpos - startpos;
+        auto length = std::sqrt(diff.x * diff.x + diff.y * diff.y);
+        auto dashes = pattern.count == 0 ? 1 : CountPatternDashes(length, pattern);
+
+        auto& target = Record(TP_PatternLine, (std::size_t)dashes * 4u);
+        Log(" %.1f %.1f %.1f %.1f %08x %d %.1f\n", startpos.x, startpos.y, endpos.x, endpos.y, color, (int)type, thickness);
+        target.DrawPatternLine(startpos, endpos, color, type, thickness);
+    }
+
+    void TracingRenderer::DrawPatternRect(ImVec2 startpos, ImVec2 endpos, uint32_t color, LineType type, float thickness)
+    {
+        auto pattern = GetLinePattern(type, thickness);
+        auto perimeter = 2.f * ((endpos.x - startpos.x) + (endpos.y - startpos.y));
+        auto dashes = pattern.count == 0 ? 4 : CountPatternDashes(perimeter, pattern);
+
+        auto& target = Record(TP_PatternRect, (std::size_t)dashes * 4u);
+        Log(" %.1f %.1f %.1f %.1f %08x %d %.1f\n", startpos.x, startpos.y, endpos.x, endpos.y, color, (int)type, thickness);
+        target.DrawPatternRect(startpos, endpos, color, type, thickness);
+    }
+
+    void TracingRenderer::DrawMesh(const ImVec2* positions, const uint32_t* colors, int vtxcount,
+        const uint32_t* indices, int idxcount, ImVec2 offset)
+    {
+        auto& target = Record(TP_Mesh, (std::size_t)vtxcount);
+        Log(" %d %d %.1f %.1f\n", vtxcount, idxcount, offset.x, offset.y);
+        target.DrawMesh(positions, colors, vtxcount, indices, idxcount, offset);
+    }
+
+    void TracingRenderer::RecordFont(std::string_view family, void* fontptr, float sz, FontType type)
+    {
+        if (family == _lastFamily && fontptr == _lastFontPtr && sz == _lastFontSize && type == _lastFontType)
+            return;
+
+        current.fontChanges++;
+        _lastFamily.assign(family.data(), family.size());
+        _lastFontPtr = fontptr;
+        _lastFontSize = sz;
+        _lastFontType = type;
+    }
+
+    bool TracingRenderer::SetCurrentFont(std::string_view family, float sz, FontType type)
+    {
+        RecordFont(family, nullptr, sz, type);
+        Log("SetCurrentFont %.*s %.1f %d\n", (int)family.size(), family.data(), sz, (int)type);
+        renderer.UserData = UserData;
+        return renderer.SetCurrentFont(family, sz, type);
+    }
+
+    bool TracingRenderer::SetCurrentFont(void* fontptr, float sz)
+    {
+        RecordFont({}, fontptr, sz, FT_Total);
+        Log("SetCurrentFont %p %.1f\n", fontptr, sz);
+        renderer.UserData = UserData;
+        return renderer.SetCurrentFont(fontptr, sz);
+    }
+
+    void TracingRenderer::ResetFont()
+    {
+        Log("ResetFont\n");
+        renderer.ResetFont();
+    }
+
+    ImVec2 TracingRenderer::GetTextSize(std::string_view text, void* fontptr, float sz)
+    {
+        return renderer.GetTextSize(text, fontptr, sz);
+    }
+
+    void TracingRenderer::GetTextSizes(const std::string_view* texts, int count, void* fontptr, float sz, ImVec2* sizes)
+    {
+        renderer.GetTextSizes(texts, count, fontptr, sz, sizes);
+    }
+
+    void TracingRenderer::DrawText(std::string_view text, ImVec2 pos, uint32_t color)
+    {
+        current.textBytes += text.size();
+        auto& target = Record(TP_Text, text.size() * 4u);
+        Log(" %.1f %.1f %08x \"%.*s\"\n", pos.x, pos.y, color, (int)text.size(), text.data());
+        target.DrawText(text, pos, color);
+    }
+
+    void TracingRenderer::DrawText(std::string_view text, std::string_view family, ImVec2 pos, float sz, uint32_t color, FontType type)
+    {
+        current.textBytes += text.size();
+        auto& target = Record(TP_Text, text.size() * 4u);
+        Log(" %.1f %.1f %08x \"%.*s\" %.*s %.1f %d\n", pos.x, pos.y, color, (int)text.size(), text.data(),
+            (int)family.size(), family.data(), sz, (int)type);
+        target.DrawText(text, family, pos, sz, color, type);
+    }
+
+    void TracingRenderer::DrawTooltip(ImVec2 pos, std::string_view text)
+    {
+        if (text.empty())
+        {
+            renderer.UserData = UserData;
+            renderer.DrawTooltip(pos, text);
+            return;
+        }
+
+        auto& target = Record(TP_Tooltip, 0);
+        Log(" %.1f %.1f \"%.*s\"\n", pos.x, pos.y, (int)text.size(), text.data());
+        target.DrawTooltip(pos, text);
+    }
+
+    float TracingRenderer::EllipsisWidth(void* fontptr, float sz)
+    {
+        return renderer.EllipsisWidth(fontptr, sz);
+    }
+
+    void TracingRenderer::EvictTextCache(std::string_view source)
+    {
+        renderer.EvictTextCache(source);
+    }
+
+#ifdef IM_RICHTEXT_TARGET_IMGUI
+
+    ImGuiRenderer::ImGuiRenderer(RenderConfig& cfg)
+        : config{ cfg } {}
+
+    void ImGuiRenderer::SetClipRect(ImVec2 startpos, ImVec2 endpos)
+    {
+        ImGui::PushClipRect(startpos, endpos, true);
+    }
+
+    void ImGuiRenderer::ResetClipRect()
+    {
+        ImGui::PopClipRect();
+    }
+
+    void ImGuiRenderer::DrawLine(ImVec2 startpos, ImVec2 endpos, uint32_t color, float thickness)
+    {
+        ((ImDrawList*)UserData)->AddLine(startpos, endpos, color, thickness);
+    }
+
+    void ImGuiRenderer::DrawPolyline(ImVec2* points, int sz, uint32_t color, float thickness)
+    {
+        ((ImDrawList*)UserData)->AddPolyline(points, sz, color, 0, thickness);
+    }
+
+    void ImGuiRenderer::DrawTriangle(ImVec2 pos1, ImVec2 pos2, ImVec2 pos3, uint32_t color, bool filled, bool thickness)
+    {
+        filled ? ((ImDrawList*)UserData)->AddTriangleFilled(pos1, pos2, pos3, color) :
+            ((ImDrawList*)UserData)->AddTriangle(pos1, pos2, pos3, color, thickness);
+    }
+
+    void ImGuiRenderer::DrawRect(ImVec2 startpos, ImVec2 endpos, uint32_t color, bool filled, float thickness)
+    {
+        if (thickness > 0.f || filled)
+        {
+            filled ? ((ImDrawList*)UserData)->AddRectFilled(startpos, endpos, color) :
+                ((ImDrawList*)UserData)->AddRect(startpos, endpos, color, 0.f, 0, thickness);
+        }
+    }
+
+    void ImGuiRenderer::DrawRoundedRect(ImVec2 startpos, ImVec2 endpos, uint32_t color, bool filled, 
+        float topleftr, float toprightr, float bottomrightr, float bottomleftr, float thickness)
+    {
+        auto isUniformRadius = (topleftr == toprightr && toprightr == bottomrightr && bottomrightr == bottomleftr) ||
+            ((topleftr + toprightr + bottomrightr + bottomleftr) == 0.f);
+
+        if (isUniformRadius)
+        {
+            auto drawflags = 0;
+
+            if (topleftr > 0.f) drawflags |= ImDrawFlags_RoundCornersTopLeft;
+            if (toprightr > 0.f) drawflags |= ImDrawFlags_RoundCornersTopRight;
+            if (bottomrightr > 0.f) drawflags |= ImDrawFlags_RoundCornersBottomRight;
+            if (bottomleftr > 0.f) drawflags |= ImDrawFlags_RoundCornersBottomLeft;
+
+            filled ? ((ImDrawList*)UserData)->AddRectFilled(startpos, endpos, color, toprightr, drawflags) :
+                ((ImDrawList*)UserData)->AddRect(startpos, endpos, color, toprightr, drawflags, thickness);
+        }
+        else
+        {
+            auto& dl = *((ImDrawList*)UserData);
+            auto minlength = std::min(endpos.x - startpos.x, endpos.y - startpos.y);
+            topleftr = std::min(topleftr, minlength);
+            toprightr = std::min(toprightr, minlength);
+            bottomrightr = std::min(bottomrightr, minlength);
+            bottomleftr = std::min(bottomleftr, minlength);
+
+            dl.PathClear();
+            dl.PathLineTo(ImVec2{ startpos.x, endpos.y - bottomleftr });
+            dl.PathLineTo(ImVec2{ startpos.x, startpos.y + topleftr });
+            if (topleftr > 0.f) dl.PathArcToFast(ImVec2{ startpos.x + topleftr, startpos.y + topleftr }, topleftr, 6, 9);
+            dl.PathLineTo(ImVec2{ endpos.x - toprightr, startpos.y });
+            if (toprightr > 0.f) dl.PathArcToFast(ImVec2{ endpos.x - toprightr, startpos.y + toprightr }, toprightr, 9, 12);
+            dl.PathLineTo(ImVec2{ endpos.x, endpos.y - bottomrightr });
+            if (bottomrightr > 0.f) dl.PathArcToFast(ImVec2{ endpos.x - bottomrightr, endpos.y - bottomrightr }, bottomrightr, 0, 3);
+            dl.PathLineTo(ImVec2{ startpos.x - bottomleftr, endpos.y });
+            if (bottomleftr > 0.f) dl.PathArcToFast(ImVec2{ startpos.x + bottomleftr, endpos.y - bottomleftr }, bottomleftr, 3, 6);
+            
+            filled ? dl.PathFillConvex(color) : dl.PathStroke(color, 0, thickness);
+        }
+    }
+
+    void ImGuiRenderer::DrawRectGradient(ImVec2 startpos, ImVec2 endpos, uint32_t topleftcolor, uint32_t toprightcolor, uint32_t bottomrightcolor, uint32_t bottomleftcolor)
+    {
+        ((ImDrawList*)UserData)->AddRectFilledMultiColor(startpos, endpos, topleftcolor, toprightcolor, bottomrightcolor, bottomleftcolor);
+    }
+
+    void ImGuiRenderer::DrawCircle(ImVec2 center, float radius, uint32_t color, bool filled, bool thickness)
+    {
+        filled ? ((ImDrawList*)UserData)->AddCircleFilled(center, radius, color) :
+            ((ImDrawList*)UserData)->AddCircle(center, radius, color, 0, thickness);
+    }
+
+    void ImGuiRenderer::DrawPolygon(ImVec2* points, int sz, uint32_t color, bool filled, float thickness)
+    {
+        filled ? ((ImDrawList*)UserData)->AddConvexPolyFilled(points, sz, color) :
+            ((ImDrawList*)UserData)->AddPolyline(points, sz, color, ImDrawFlags_Closed, thickness);
+    }
+
+    void ImGuiRenderer::DrawPolyGradient(ImVec2* points, uint32_t* colors, int sz)
+    {
+        auto drawList = ((ImDrawList*)UserData);
+        const ImVec2 uv = drawList->_Data->TexUvWhitePixel;
+
+        if (drawList->Flags & ImDrawListFlags_AntiAliasedFill)
+        {
+            // Anti-aliased Fill
+            const float AA_SIZE = 1.0f;
+            const int idx_count = (sz - 2) * 3 + sz * 6;
+            const int vtx_count = (sz * 2);
+            drawList->PrimReserve(idx_count, vtx_count);
+
+            // Add indexes for fill
+            unsigned int vtx_inner_idx = drawList->_VtxCurrentIdx;
+            unsigned int vtx_outer_idx = drawList->_VtxCurrentIdx + 1;
+            for (int i = 2; i < sz; i++)
+            {
+                drawList->_IdxWritePtr[0] = (ImDrawIdx)(vtx_inner_idx);
+                drawList->_IdxWritePtr[1] = (ImDrawIdx)(vtx_inner_idx + ((i - 1) << 1));
+                drawList->_IdxWritePtr[2] = (ImDrawIdx)(vtx_inner_idx + (i << 1));
+                drawList->_IdxWritePtr += 3;
+            }
+
+            // Compute normals
+            ImVec2* temp_normals = (ImVec2*)alloca(sz * sizeof(ImVec2));
+            for (int i0 = sz - 1, i1 = 0; i1 < sz; i0 = i1++)
+            {
+                const ImVec2& p0 = points[i0];
+                const ImVec2& p1 = points[i1];
+                ImVec2 diff = p1 - p0;
+                diff *= ImInvLength(diff, 1.0f);
+                temp_normals[i0].x = diff.y;
+                temp_normals[i0].y = -diff.x;
+            }
+
+            for (int i0 = sz - 1, i1 = 0; i1 < sz; i0 = i1++)
+            {
+                // Average normals
+                const ImVec2& n0 = temp_normals[i0];
+                const ImVec2& n1 = temp_normals[i1];
+                ImVec2 dm = (n0 + n1) * 0.5f;
+                float dmr2 = dm.x * dm.x + dm.y * dm.y;
+                if (dmr2 > 0.000001f)
+                {
+                    float scale = 1.0f / dmr2;
+                    if (scale > 100.0f) scale = 100.0f;
+                    dm *= scale;
+                }
+                dm *= AA_SIZE * 0.5f;
+
+                // Add vertices
+                drawList->_VtxWritePtr[0].pos = (points[i1] - dm);
+                drawList->_VtxWritePtr[0].uv = uv; drawList->_VtxWritePtr[0].col = colors[i1];        // Inner
+                drawList->_VtxWritePtr[1].pos = (points[i1] + dm);
+                drawList->_VtxWritePtr[1].uv = uv; drawList->_VtxWritePtr[1].col = colors[i1] & ~IM_COL32_A_MASK;  // Outer
+                drawList->_VtxWritePtr += 2;
+
+                // Add indexes for fringes
+                drawList->_IdxWritePtr[0] = (ImDrawIdx)(vtx_inner_idx + (i1 << 1));
+                drawList->_IdxWritePtr[1] = (ImDrawIdx)(vtx_inner_idx + (i0 << 1));
+                drawList->_IdxWritePtr[2] = (ImDrawIdx)(vtx_outer_idx + (i0 << 1));
+                drawList->_IdxWritePtr[3] = (ImDrawIdx)(vtx_outer_idx + (i0 << 1));
+                drawList->_IdxWritePtr[4] = (ImDrawIdx)(vtx_outer_idx + (i1 << 1));
+                drawList->_IdxWritePtr[5] = (ImDrawIdx)(vtx_inner_idx + (i1 << 1));
+                drawList->_IdxWritePtr += 6;
+            }
+
+            drawList->_VtxCurrentIdx += (ImDrawIdx)vtx_count;
+        }
+        else
+        {
+            // Non Anti-aliased Fill
+            const int idx_count = (sz - 2) * 3;
+            const int vtx_count = sz;
+            drawList->PrimReserve(idx_count, vtx_count);
+            for (int i = 0; i < vtx_count; i++)
+            {
+                drawList->_VtxWritePtr[0].pos = points[i];
+                drawList->_VtxWritePtr[0].uv = uv;
+                drawList->_VtxWritePtr[0].col = colors[i];
+                drawList->_VtxWritePtr++;
+            }
+            for (int i = 2; i < sz; i++)
+            {
+                drawList->_IdxWritePtr[0] = (ImDrawIdx)(drawList->_VtxCurrentIdx);
+                drawList->_IdxWritePtr[1] = (ImDrawIdx)(drawList->_VtxCurrentIdx + i - 1);
+                drawList->_IdxWritePtr[2] = (ImDrawIdx)(drawList->_VtxCurrentIdx + i);
+                drawList->_IdxWritePtr += 3;
+            }
+
+            drawList->_VtxCurrentIdx += (ImDrawIdx)vtx_count;
+        }
+    }
+
+    void ImGuiRenderer::DrawRadialGradient(ImVec2 center, float radius, uint32_t in, uint32_t out, int start, int end)
+    {
+        auto drawList = ((ImDrawList*)UserData);
+        if (((in | out) & IM_COL32_A_MASK) == 0 || radius < 0.5f)
+            return;
+        auto startrad = ((float)M_PI / 180.f) * (float)start;
+        auto endrad = ((float)M_PI / 180.f) * (float)end;
+
+        // Use arc with 32 segment count
+        drawList->PathArcTo(center, radius, startrad, endrad, 32);
+        const int count = drawList->_Path.Size - 1;
+
+        unsigned int vtx_base = drawList->_VtxCurrentIdx;
+        drawList->PrimReserve(count * 3, count + 1);
+
+        // Submit vertices
+        const ImVec2 uv = drawList->_Data->TexUvWhitePixel;
+        drawList->PrimWriteVtx(center, uv, in);
+        for (int n = 0; n < count; n++)
+            drawList->PrimWriteVtx(drawList->_Path[n], uv, out);
+
+        // Submit a fan of triangles
+        for (int n = 0; n < count; n++)
+        {
+            drawList->PrimWriteIdx((ImDrawIdx)(vtx_base));
+            drawList->PrimWriteIdx((ImDrawIdx)(vtx_base + 1 + n));
+            drawList->PrimWriteIdx((ImDrawIdx)(vtx_base + 1 + ((n + 1) % count)));
+        }
+
+        drawList->_Path.Size = 0;
+    }
+
+    // Emits one quad per dash, quads are reserved in batches to stay within 16-bit indices
+    static void AddPatternDashes(ImDrawList& dl, ImVec2 startpos, ImVec2 endpos, uint32_t color, 
+        const LinePattern& pattern, float thickness)
+    {
+        constexpr int MaxDashesPerBatch = 4096;
+
+        auto diff = endpos - startpos;
+        auto length = ImSqrt(ImLengthSqr(diff));
+        if (length <= 0.f) return;
+
+        auto total = CountPatternDashes(length, pattern);
+        auto dir = diff / length;
+        auto normal = ImVec2{ -dir.y, dir.x } * (thickness * 0.5f);
+        const auto uv = dl._Data->TexUvWhitePixel;
+        auto current = 0.f;
+        auto segment = 0;
+
+        while (total > 0)
+        {
+            auto reserved = std::min(total, MaxDashesPerBatch);
+            dl.PrimReserve(reserved * 6, reserved * 4);
+            total -= reserved;
+
+            for (; reserved > 0; segment = (segment + 1) % pattern.count)
+            {
+                auto next = std::min(current + pattern.segments[segment], length);
+
+                if ((segment % 2) == 0)
+                {
+                    auto from = startpos + dir * current, to = startpos + dir * next;
+                    dl.PrimQuadUV(from + normal, to + normal, to - normal, from - normal, uv, uv, uv, uv, color);
+                    reserved--;
+                }
+
+                current = next;
+            }
+        }
+    }
+
+    void ImGuiRenderer::DrawPatternLine(ImVec2 startpos, ImVec2 endpos, uint32_t color, LineType type, float thickness)
+    {
+        auto pattern = GetLinePattern(type, thickness);
+        if (pattern.count == 0) DrawLine(startpos, endpos, color, thickness);
+        else AddPatternDashes(*((ImDrawList*)UserData), startpos, endpos, color, pattern, thickness);
+    }
+
+    void ImGuiRenderer::DrawPatternRect(ImVec2 startpos, ImVec2 endpos, uint32_t color, LineType type, float thickness)
+    {
+        auto pattern = GetLinePattern(type, thickness);
+
+        if (pattern.count == 0) DrawRect(startpos, endpos, color, false, thickness);
+        else
+        {
+            // Same stroke placement as ImDrawList::AddRect
+            auto& dl = *((ImDrawList*)UserData);
+            auto topleft = startpos + ImVec2{ 0.5f, 0.5f }, bottomright = endpos - ImVec2{ 0.5f, 0.5f };
+            ImVec2 topright{ bottomright.x, topleft.y }, bottomleft{ topleft.x, bottomright.y };
+
+            AddPatternDashes(dl, topleft, topright, color, pattern, thickness);
+            AddPatternDashes(dl, topright, bottomright, color, pattern, thickness);
+            AddPatternDashes(dl, bottomright, bottomleft, color, pattern, thickness);
+            AddPatternDashes(dl, bottomleft, topleft, color, pattern, thickness);
+        }
+    }
+
+    void ImGuiRenderer::DrawMesh(const ImVec2* positions, const uint32_t* colors, int vtxcount,
+        const uint32_t* indices, int idxcount, ImVec2 offset)
+    {
+        auto& dl = *((ImDrawList*)UserData);
+        const auto uv = dl._Data->TexUvWhitePixel;
+
+        if (sizeof(ImDrawIdx) > 2 || vtxcount < (1 << 16))
+        {
+            dl.PrimReserve(idxcount, vtxcount);
+            auto base = dl._VtxCurrentIdx;
+
+            for (auto vtx = 0; vtx < vtxcount; ++vtx)
+            {
+                dl._VtxWritePtr[vtx].pos = positions[vtx] + offset;
+                dl._VtxWritePtr[vtx].uv = uv;
+                dl._VtxWritePtr[vtx].col = colors[vtx];
+            }
+
+            for (auto idx = 0; idx < idxcount; ++idx)
+                dl._IdxWritePtr[idx] = (ImDrawIdx)(base + indices[idx]);
+
+            dl._VtxWritePtr += vtxcount;
+            dl._IdxWritePtr += idxcount;
+            dl._VtxCurrentIdx += (unsigned int)vtxcount;
+        }
+        else
+        {
+            // Too many vertices to address with 16-bit indices, submit unindexed batches of triangles
+            constexpr int MaxTrianglesPerBatch = 8192;
+
+            for (auto idx = 0; idx + 2 < idxcount;)
+            {
+                auto count = std::min((idxcount - idx) / 3, MaxTrianglesPerBatch) * 3;
+                dl.PrimReserve(count, count);
+
+                for (auto end = idx + count; idx < end; ++idx)
+                {
+                    dl.PrimWriteIdx((ImDrawIdx)dl._VtxCurrentIdx);
+                    dl.PrimWriteVtx(positions[indices[idx]] + offset, uv, colors[indices[idx]]);
+                }
+            }
+        }
+    }
+
+    bool ImGuiRenderer::SetCurrentFont(std::string_view family, float sz, FontType type)
+    {
+        auto font = GetFont(family, sz, type);
+
+        if (font != nullptr) 
+        {
+            _currentFontSz = sz;
+            ImGui::PushFont((ImFont*)font); 
+            return true;
+        }
+
+        return false;
+    }
+
+    bool ImGuiRenderer::SetCurrentFont(void* fontptr, float sz)
+    {
+        if (fontptr != nullptr) 
+        {
+            _currentFontSz = sz;
+            ImGui::PushFont((ImFont*)fontptr); 
+            return true;
+        }
+
+        return false;
+    }
+
+    void ImGuiRenderer::ResetFont()
+    {
+        ImGui::PopFont();
+    }
+
+    ImVec2 ImGuiRenderer::GetTextSize(std::string_view text, void* fontptr, float sz)
+    {
+        IM_RICHTEXT_PROFILE_SCOPE(Measurement, text.size());
+        auto imfont = (ImFont*)fontptr;
+        ImGui::PushFont(imfont);
+        auto txtsz = ImGui::CalcTextSize(text.data(), text.data() + text.size());
+        ImGui::PopFont();
+
+        auto ratio = (sz / imfont->FontSize);
+        txtsz.x *= ratio;
+        txtsz.y *= ratio;
+        return txtsz;
+    }
+
+    void ImGuiRenderer::GetTextSizes(const std::string_view* texts, int count, void* fontptr, float sz, ImVec2* sizes)
+    {
+        IM_RICHTEXT_PROFILE_SCOPE(Measurement, 0);
+        auto imfont = (ImFont*)fontptr;
+        auto ratio = (sz / imfont->FontSize);
+        [[maybe_unused]] std::size_t bytes = 0;
+        ImGui::PushFont(imfont);
+
+        for (auto idx = 0; idx < count; ++idx)
+        {
+            sizes[idx] = ImGui::CalcTextSize(texts[idx].data(), texts[idx].data() + texts[idx].size());
+            sizes[idx].x *= ratio;
+            sizes[idx].y *= ratio;
+            bytes += texts[idx].size();
+        }
+
+        ImGui::PopFont();
+        IM_RICHTEXT_PROFILE_BYTES(bytes);
+    }
+
+    void ImGuiRenderer::DrawText(std::string_view text, ImVec2 pos, uint32_t color)
+    {
+        auto font = ImGui::GetFont();
+        ((ImDrawList*)UserData)->AddText(font, _currentFontSz, pos, color, text.data(), text.data() + text.size());
+    }
+
+    void ImGuiRenderer::DrawText(std::string_view text, std::string_view family, ImVec2 pos, float sz, uint32_t color, FontType type)
+    {
+        auto popFont = false;
+        auto font = GetFont(family, sz, type);
+
+        if (font != nullptr) 
+        {
+            ImGui::PushFont((ImFont*)font); 
+            popFont = true;
+        }
+
+        ((ImDrawList*)UserData)->AddText((ImFont*)font, sz, pos, color, text.data(), text.data() + text.size());
+        if (popFont) ImGui::PopFont();
+    }
+
+    void ImGuiRenderer::DrawTooltip(ImVec2 pos, std::string_view text)
+    {
+        if (!text.empty())
+        {
+            SetCurrentFont(config.DefaultFontFamily, config.DefaultFontSize, FT_Normal);
+            ImGui::SetTooltip("%.*s", (int)text.size(), text.data());
+            ResetFont();
+        }
+    }
+
+    float ImGuiRenderer::EllipsisWidth(void* fontptr, float sz)
+    {
+        return ((ImFont*)fontptr)->EllipsisWidth;
+    }
+
+    ImVec2 ImGuiPlatform::GetCurrentMousePos()
+    {
+        return ImGui::GetIO().MousePos;
+    }
+
+    bool ImGuiPlatform::IsMouseClicked()
+    {
+        return ImGui::GetIO().MouseReleased[0];
+    }
+
+    void ImGuiPlatform::HandleHyperlink(std::string_view link)
+    {
+        if (HyperlinkClicked != nullptr)
+            HyperlinkClicked(link);
+    }
+
+    void ImGuiPlatform::HandleHover(bool hovered)
+    {
+        hovered ? ImGui::SetMouseCursor(ImGuiMouseCursor_Hand) :
+            ImGui::SetMouseCursor(ImGuiMouseCursor_Arrow);
+    }
+
+    ImVec2 ImGuiGlyphSource::GetTextSize(std::string_view text, void* fontptr, float sz)
+    {
+        return ((ImFont*)fontptr)->CalcTextSizeA(sz, FLT_MAX, 0.f, text.data(), text.data() + text.size());
+    }
+
+    float ImGuiGlyphSource::EllipsisWidth(void* fontptr, float sz)
+    {
+        auto font = (ImFont*)fontptr;
+        return font->EllipsisWidth * (sz / font->FontSize);
+    }
+
+    void ImGuiGlyphSource::RasterizeText(std::string_view text, void* fontptr, float sz, ImVec2 pos,
+        GlyphCoverage& coverage)
+    {
+        // The atlas is never (re)built here, as it may be in use by the rendering backend
+        auto font = (ImFont*)fontptr;
+        auto atlas = font != nullptr ? font->ContainerAtlas : nullptr;
+        if (atlas == nullptr || (atlas->TexPixelsAlpha8 == nullptr && atlas->TexPixelsRGBA32 == nullptr)) return;
+
+        const unsigned char* alpha8 = atlas->TexPixelsAlpha8;
+        const unsigned int* rgba32 = atlas->TexPixelsRGBA32;
+        const auto texw = atlas->TexWidth, texh = atlas->TexHeight;
+        if (texw <= 0 || texh <= 0) return;
+
+        auto texel = [&](int x, int y) {
+            x = std::min(std::max(x, 0), texw - 1);
+            y = std::min(std::max(y, 0), texh - 1);
+            return alpha8 != nullptr ? (float)alpha8[y * texw + x] : (float)(rgba32[y * texw + x] >> IM_COL32_A_SHIFT);
+        };
+
+        auto forEachGlyph = [&](auto&& callback) {
+            // Snap to pixels like ImFont::RenderText
+            auto scale = sz / font->FontSize;
+            auto x = std::floor(pos.x), y = std::floor(pos.y);
+            auto current = text.data(), end = text.data() + text.size();
+
+            while (current < end)
+            {
+                unsigned int codepoint = (unsigned char)*current;
+                if (codepoint < 0x80) ++current;
+                else current += ImTextCharFromUtf8(&codepoint, current, end);
+                if (codepoint == 0) break;
+                if (codepoint == '\n' || codepoint == '\r') continue;
+
+                auto glyph = font->FindGlyph((ImWchar)codepoint);
+                if (glyph == nullptr) continue;
+
+                if (glyph->Visible)
+                    callback(*glyph, ImVec2{ x + glyph->X0 * scale, y + glyph->Y0 * scale },
+                        ImVec2{ x + glyph->X1 * scale, y + glyph->Y1 * scale });
+
+                x += glyph->AdvanceX * scale;
+            }
+        };
+
+        ImVec2 min{ FLT_MAX, FLT_MAX }, max{ -FLT_MAX, -FLT_MAX };
+        forEachGlyph([&](const ImFontGlyph&, ImVec2 gmin, ImVec2 gmax) {
+            min = ImMin(min, gmin);
+            max = ImMax(max, gmax);
+        });
+
+        if (min.x >= max.x || min.y >= max.y) return;
+
+        coverage.left = (int)std::floor(min.x);
+        coverage.top = (int)std::floor(min.y);
+        coverage.width = (int)std::ceil(max.x) - coverage.left;
+        coverage.height = (int)std::ceil(max.y) - coverage.top;
+        coverage.alpha.assign((std::size_t)coverage.width * (std::size_t)coverage.height, 0);
+
+        // Glyphs are sampled bilinearly from the atlas
+        forEachGlyph([&](const ImFontGlyph& glyph, ImVec2 gmin, ImVec2 gmax) {
+            auto uscale = (glyph.U1 - glyph.U0) / std::max(gmax.x - gmin.x, 0.0001f);
+            auto vscale = (glyph.V1 - glyph.V0) / std::max(gmax.y - gmin.y, 0.0001f);
+
+            for (auto py = (int)std::floor(gmin.y); py < (int)std::ceil(gmax.y); ++py)
+            {
+                auto v = (glyph.V0 + ((float)py + 0.5f - gmin.y) * vscale) * (float)texh - 0.5f;
+                auto ty = (int)std::floor(v);
+                auto fy = v - (float)ty;
+                auto row = coverage.alpha.data() + (std::size_t)(py - coverage.top) * (std::size_t)coverage.width;
+
+                for (auto px = (int)std::floor(gmin.x); px < (int)std::ceil(gmax.x); ++px)
+                {
+                    auto u = (glyph.U0 + ((float)px + 0.5f - gmin.x) * uscale) * (float)texw - 0.5f;
+                    auto tx = (int)std::floor(u);
+                    auto fx = u - (float)tx;
+                    auto top = texel(tx, ty) + (texel(tx + 1, ty) - texel(tx, ty)) * fx;
+                    auto bottom = texel(tx, ty + 1) + (texel(tx + 1, ty + 1) - texel(tx, ty + 1)) * fx;
+                    auto& alpha = row[px - coverage.left];
+                    alpha = (unsigned char)std::min((float)alpha + top + (bottom - top) * fy + 0.5f, 255.f);
+                }
+            }
+        });
+    }
+
+#endif
+#ifdef IM_RICHTEXT_TARGET_BLEND2D
+
+    Blend2DRenderer::Blend2DRenderer(BLContext& ctx) : context{ ctx } {}
+
+    void Blend2DRenderer::SetClipRect(ImVec2 startpos, ImVec2 endpos)
+    {
+        context.clipToRect(BLRect{ startpos.x, startpos.y, endpos.x - startpos.x, endpos.y - startpos.y });
+    }
+
+    void Blend2DRenderer::ResetClipRect()
+    {
+        context.restoreClipping();
+    }
+
+    void Blend2DRenderer::DrawLine(ImVec2 startpos, ImVec2 endpos, uint32_t color, float thickness)
+    {
+        BLLine line;
+        line.x0 = startpos.x;
+        line.x1 = endpos.x;
+        line.y0 = startpos.y;
+        line.y1 = endpos.y;
+
+        BLRgba32 rgba{ color };
+        context.setStrokeWidth(thickness);
+        context.setStrokeStyle(rgba);
+        context.strokeLine(line);
+    }
+
+    void Blend2DRenderer::DrawPolyline(ImVec2* points, int sz, uint32_t color, float thickness)
+    {
+        thread_local static BLPoint blpoints[64];
+        assert(sz < 64);
+        std::memset(points, 0, sizeof(BLPoint) * 64);
+        for (auto idx = 0; idx < sz; ++idx) {
+            blpoints[idx].x = points[idx].x;
+            blpoints[idx].y = points[idx].y;
+        }
+
+        BLRgba32 rgba{ color };
+        context.setStrokeWidth(thickness);
+        context.setStrokeStyle(rgba);
+        context.strokePolyline(blpoints, sz);
+    }
+
+    void Blend2DRenderer::DrawTriangle(ImVec2 pos1, ImVec2 pos2, ImVec2 pos3, uint32_t color, bool filled, bool thickness)
+    {
+        BLRgba32 rgba{ color };
+        context.setStrokeWidth(thickness);
+        context.setStrokeStyle(rgba);
+        if (filled) context.setFillStyle(rgba);
+        else context.setFillStyle(IM_COL32_BLACK_TRANS);
+        context.strokeTriangle(pos1.x, pos1.y, pos2.x, pos2.y, pos3.x, pos3.y);
+    }
+
+    void Blend2DRenderer::DrawRect(ImVec2 startpos, ImVec2 endpos, uint32_t color, bool filled, float thickness)
+    {
+        BLRgba32 rgba{ color };
+        context.setStrokeWidth(thickness);
+        context.setStrokeStyle(rgba);
+        if (filled) context.setFillStyle(rgba);
+        else context.setFillStyle(IM_COL32_BLACK_TRANS);
+        context.strokeRect(startpos.x, startpos.y, endpos.x - startpos.x, endpos.y - startpos.y);
+    }
+
+    void Blend2DRenderer::DrawRectGradient(ImVec2 startpos, ImVec2 endpos, uint32_t topleftcolor, uint32_t toprightcolor, uint32_t bottomrightcolor, uint32_t bottomleftcolor)
+    {
+        BLGradient gradient;
+        gradient.setType(BLGradientType::BL_GRADIENT_TYPE_LINEAR);
+        gradient.setX0(startpos.x);
+        gradient.setX1(endpos.x);
+        gradient.setY0(startpos.y);
+        gradient.setY1(endpos.y);
+        gradient.addStop(0.f, BLRgba32{ topleftcolor });
+        gradient.addStop(1.f, BLRgba32{ bottomrightcolor });
+        context.setFillStyle(gradient);
+        context.strokeRect(startpos.x, startpos.y, endpos.x - startpos.x, endpos.y - startpos.y);
+    }
+
+    void Blend2DRenderer::DrawRoundedRect(ImVec2 startpos, ImVec2 endpos, uint32_t color, bool filled, float topleftr, float toprightr, float bottomrightr, float bottomleftr, float thickness)
+    {
+        auto isUniformRadius = toprightr == toprightr && toprightr == bottomrightr && bottomrightr == bottomleftr;
+        BLRgba32 rgba{ color };
+        context.setStrokeWidth(thickness);
+        context.setStrokeStyle(rgba);
+        if (filled) context.setFillStyle(rgba);
+        else context.setFillStyle(IM_COL32_BLACK_TRANS);
+
+        if (isUniformRadius)
+        {
+            context.strokeRoundedRect(startpos.x, startpos.y, endpos.x - startpos.x, endpos.y - startpos.y, topleftr, bottomrightr);
+        }
+        else
+        {
+            BLPath path;
+            path.moveTo(startpos.x, endpos.y - bottomleftr);
+            path.lineTo(startpos.x, startpos.y + topleftr);
+            if (topleftr > 0.f) path.arcTo(startpos.x + topleftr, startpos.y + topleftr, topleftr, topleftr, M_PI, 1.5 * M_PI);
+            path.lineTo(endpos.x - toprightr, startpos.y);
+            if (toprightr > 0.f) path.arcTo(endpos.x - toprightr, startpos.y + toprightr, toprightr, toprightr, 1.5 * M_PI, 2.0 * M_PI);
+            path.lineTo(endpos.x, endpos.y - bottomrightr);
+            if (bottomrightr > 0.f) path.arcTo(endpos.x - bottomrightr, endpos.y - bottomrightr, bottomrightr, bottomrightr, 0.0, 0.5 * M_PI);
+            path.lineTo(startpos.x - bottomleftr, endpos.y);
+            if (bottomleftr > 0.f) path.arcTo(startpos.x + bottomleftr, endpos.y - bottomleftr, bottomleftr, bottomleftr, 0.5 * M_PI, M_PI);
+
+            context.strokePath(path);
+        }
+    }
+
+    void Blend2DRenderer::DrawPolygon(ImVec2* points, int sz, uint32_t color, bool filled, float thickness)
+    {
+        thread_local static BLPoint blpoints[64];
+        assert(sz < 64);
+        std::memset(points, 0, sizeof(BLPoint) * 64);
+        for (auto idx = 0; idx < sz; ++idx) {
+            blpoints[idx].x = points[idx].x;
+            blpoints[idx].y = points[idx].y;
+        }
+
+        BLRgba32 rgba{ color };
+        context.setStrokeWidth(thickness);
+        context.setStrokeStyle(rgba);
+        if (filled) context.setFillStyle(rgba);
+        else context.setFillStyle(IM_COL32_BLACK_TRANS);
+        context.strokePolygon(blpoints, sz);
+    }
+
+    void Blend2DRenderer::DrawPolyGradient(ImVec2* points, uint32_t* colors, int sz)
+    {
+        // TODO: figure this out...
+    }
+
+    void Blend2DRenderer::DrawCircle(ImVec2 center, float radius, uint32_t color, bool filled, bool thickness)
+    {
+        BLRgba32 rgba{ color };
+        context.setStrokeWidth(thickness);
+        context.setStrokeStyle(rgba);
+        if (filled) context.setFillStyle(rgba);
+        else context.setFillStyle(IM_COL32_BLACK_TRANS);
+        context.strokeCircle(center.x, center.y, radius);
+    }
+
+    void Blend2DRenderer::DrawRadialGradient(ImVec2 center, float radius, uint32_t in, uint32_t out, int start, int end)
+    {
+        BLGradient gradient;
+        gradient.setType(BLGradientType::BL_GRADIENT_TYPE_RADIAL);
+        gradient.setX0(startpos.x);
+        gradient.setX1(startpos.x);
+        gradient.setY0(startpos.y);
+        gradient.setY1(startpos.y);
+        gradient.setR0(radius);
+        gradient.setR1(radius);
+        gradient.addStop(0.f, BLRgba32{ in });
+        gradient.addStop(1.f, BLRgba32{ out });
+        context.setFillStyle(gradient);
+        context.strokeCircle(startpos.x, startpos.y, radius);
+    }
+
+    static void AddPatternDashes(BLPath& path, ImVec2 startpos, ImVec2 endpos, const LinePattern& pattern)
+    {
+        auto diff = endpos - startpos;
+        auto length = std::sqrt(diff.x * diff.x + diff.y * diff.y);
+        if (length <= 0.f) return;
+
+        ImVec2 dir{ diff.x / length, diff.y / length };
+        auto current = 0.f;
+
+        for (auto segment = 0; current < length; segment = (segment + 1) % pattern.count)
+        {
+            auto next = std::min(current + pattern.segments[segment], length);
+
+            if ((segment % 2) == 0)
+            {
+                path.moveTo(startpos.x + dir.x * current, startpos.y + dir.y * current);
+                path.lineTo(startpos.x + dir.x * next, startpos.y + dir.y * next);
+            }
+
+            current = next;
+        }
+    }
+
+    static void StrokePatternPath(BLContext& context, const BLPath& path, uint32_t color, float thickness)
+    {
+        BLRgba32 rgba{ color };
+        context.setStrokeWidth(thickness);
+        context.setStrokeCaps(BL_STROKE_CAP_BUTT);
+        context.setStrokeStyle(rgba);
+        context.strokePath(path);
+    }
+
+    void Blend2DRenderer::DrawPatternLine(ImVec2 startpos, ImVec2 endpos, uint32_t color, LineType type, float thickness)
+    {
+        auto pattern = GetLinePattern(type, thickness);
+        if (pattern.count == 0)
+        {
+            DrawLine(startpos, endpos, color, thickness);
+            return;
+        }
+
+        BLPath path;
+        AddPatternDashes(path, startpos, endpos, pattern);
+        StrokePatternPath(context, path, color, thickness);
+    }
+
+    void Blend2DRenderer::DrawPatternRect(ImVec2 startpos, ImVec2 endpos, uint32_t color, LineType type, float thickness)
+    {
+        auto pattern = GetLinePattern(type, thickness);
+        if (pattern.count == 0)
+        {
+            DrawRect(startpos, endpos, color, false, thickness);
+            return;
+        }
+
+        BLPath path;
+        ImVec2 topright{ endpos.x, startpos.y }, bottomleft{ startpos.x, endpos.y };
+        AddPatternDashes(path, startpos, topright, pattern);
+        AddPatternDashes(path, topright, endpos, pattern);
+        AddPatternDashes(path, endpos, bottomleft, pattern);
+        AddPatternDashes(path, bottomleft, startpos, pattern);
+        StrokePatternPath(context, path, color, thickness);
+    }
+
+    // Linear gradient reproducing the vertex colors of a triangle, as Blend2D has no per-vertex
+    // colors. This is exact when the colors vary along one direction only, which holds for 
+    // shadow and gradient meshes.
+    struct MeshGradient
+    {
+        ImVec2 start, end, dir;
+        uint32_t from = 0, to = 0;
+    };
+
+    static float ColorChannel(uint32_t color, int ch)
+    {
+        return (float)((color >> (ch * 8)) & 0xFF);
+    }
+
+    static bool ComputeMeshGradient(const ImVec2* pos, const uint32_t* col, MeshGradient& result)
+    {
+        // Find the vertex pair (from, to) with largest color difference, and the
+        // relative position of the third vertex's color between them
+        auto from = 0, to = 1;
+        auto maxdiff = -1.f;
+
+        for (auto first = 0; first < 3; ++first)
+        {
+            auto second = (first + 1) % 3;
+            auto diff = 0.f;
+            for (auto ch = 0; ch < 4; ++ch)
+            {
+                auto delta = ColorChannel(col[second], ch) - ColorChannel(col[first], ch);
+                diff += delta * delta;
+            }
+
+            if (diff > maxdiff) { maxdiff = diff; from = first; to = second; }
+        }
+
+        auto third = 3 - from - to;
+        auto projected = 0.f;
+        for (auto ch = 0; ch < 4; ++ch)
+            projected += (ColorChannel(col[third], ch) - ColorChannel(col[from], ch)) *
+                (ColorChannel(col[to], ch) - ColorChannel(col[from], ch));
+        projected /= maxdiff;
+
+        // Solve for gradient vector g such that g.(to - from) = 1 and g.(third - from) = projected
+        auto a = pos[to] - pos[from], b = pos[third] - pos[from];
+        auto det = a.x * b.y - a.y * b.x;
+        if (std::fabs(det) < 1e-6f) return false;
+
+        result.dir = ImVec2{ (b.y - a.y * projected) / det, (a.x * projected - b.x) / det };
+        auto glen2 = result.dir.x * result.dir.x + result.dir.y * result.dir.y;
+        result.start = pos[from];
+        result.end = pos[from] + result.dir / glen2;
+        result.from = col[from];
+        result.to = col[to];
+        return true;
+    }
+
+    // Whether the gradient yields `color` at `pos` (padded beyond its ends, as Blend2D does)
+    static bool MatchesMeshGradient(const MeshGradient& gradient, ImVec2 pos, uint32_t color)
+    {
+        auto delta = pos - gradient.start;
+        auto t = std::clamp(gradient.dir.x * delta.x + gradient.dir.y * delta.y, 0.f, 1.f);
+
+        for (auto ch = 0; ch < 4; ++ch)
+        {
+            auto expected = ColorChannel(gradient.from, ch) + t * 
+                (ColorChannel(gradient.to, ch) - ColorChannel(gradient.from, ch));
+            if (std::fabs(expected - ColorChannel(color, ch)) > 1.f) return false;
+        }
+
+        return true;
+    }
+
+    static float Orientation(ImVec2 origin, ImVec2 pos1, ImVec2 pos2)
+    {
+        return (pos1.x - origin.x) * (pos2.y - origin.y) - (pos1.y - origin.y) * (pos2.x - origin.x);
+    }
+
+    void Blend2DRenderer::DrawMesh(const ImVec2* positions, const uint32_t* colors, int vtxcount,
+        const uint32_t* indices, int idxcount, ImVec2 offset)
+    {
+        // Runs of flat triangles of the same color are filled as a single path. Other triangles
+        // are filled with a linear gradient, merged with the next triangle into a quad when it
+        // shares an edge and continues the same gradient (as for the quads of shadow meshes).
+        BLPath flat;
+        uint32_t flatColor = 0;
+        auto flushFlat = [&] {
+            if (!flat.empty())
+            {
+                context.setFillStyle(BLRgba32{ flatColor });
+                context.fillPath(flat);
+                flat.clear();
+            }
+        };
+
+        for (auto idx = 0; idx + 2 < idxcount; idx += 3)
+        {
+            ImVec2 pos[3];
+            uint32_t col[3];
+            for (auto vtx = 0; vtx < 3; ++vtx)
+            {
+                pos[vtx] = positions[indices[idx + vtx]] + offset;
+                col[vtx] = colors[indices[idx + vtx]];
+            }
+
+            if (col[0] == col[1] && col[1] == col[2])
+            {
+                if ((col[0] & IM_COL32_A_MASK) == 0) continue;
+                if (col[0] != flatColor) flushFlat();
+                flatColor = col[0];
+
+                // Add all triangles with the same winding, so that overlapping ones do not 
+                // cancel out under the non-zero fill rule
+                auto ccw = Orientation(pos[0], pos[1], pos[2]) < 0.f;
+                flat.moveTo(pos[0].x, pos[0].y);
+                flat.lineTo(pos[ccw ? 2 : 1].x, pos[ccw ? 2 : 1].y);
+                flat.lineTo(pos[ccw ? 1 : 2].x, pos[ccw ? 1 : 2].y);
+                flat.close();
+                continue;
+            }
+
+            flushFlat();
+            MeshGradient gradient;
+            if (!ComputeMeshGradient(pos, col, gradient)) continue;
+
+            BLPath path;
+            path.moveTo(pos[0].x, pos[0].y);
+            path.lineTo(pos[1].x, pos[1].y);
+            path.lineTo(pos[2].x, pos[2].y);
+
+            if (idx + 5 < idxcount)
+            {
+                // The next triangle forms a quad with this one if it shares an edge, has its third
+                // vertex on the other side of that edge, and its color is on the same gradient
+                const auto* next = indices + idx + 3;
+                auto shared = 0, unshared = -1, other = -1;
+
+                for (auto vtx = 0; vtx < 3; ++vtx)
+                {
+                    auto found = false;
+                    for (auto nvtx = 0; nvtx < 3; ++nvtx)
+                        found = found || indices[idx + vtx] == next[nvtx];
+                    if (found) ++shared; else unshared = vtx;
+                }
+
+                for (auto nvtx = 0; nvtx < 3 && shared == 2; ++nvtx)
+                    if (next[nvtx] != indices[idx] && next[nvtx] != indices[idx + 1] && 
+                        next[nvtx] != indices[idx + 2]) other = (int)next[nvtx];
+
+                if (other != -1)
+                {
+                    auto edge1 = pos[(unshared + 1) % 3], edge2 = pos[(unshared + 2) % 3];
+                    auto fourth = positions[other] + offset;
+
+                    if ((Orientation(edge1, edge2, pos[unshared]) < 0.f) != (Orientation(edge1, edge2, fourth) < 0.f) &&
+                        MatchesMeshGradient(gradient, fourth, colors[other]))
+                    {
+                        path.clear();
+                        path.moveTo(pos[unshared].x, pos[unshared].y);
+                        path.lineTo(edge1.x, edge1.y);
+                        path.lineTo(fourth.x, fourth.y);
+                        path.lineTo(edge2.x, edge2.y);
+                        idx += 3;
+                    }
+                }
+            }
+
+            path.close();
+            BLGradient fill{ BLLinearGradientValues{ gradient.start.x, gradient.start.y, gradient.end.x, gradient.end.y } };
+            fill.addStop(0.0, BLRgba32{ gradient.from });
+            fill.addStop(1.0, BLRgba32{ gradient.to });
+            context.setFillStyle(fill);
+            context.fillPath(path);
+        }
+
+        flushFlat();
+    }
+
+    bool Blend2DRenderer::SetCurrentFont(std::string_view family, float sz, FontType type) override
+    {
+        currentFont = GetFont(family, sz, type);
+        return currentFont != nullptr;
+    }
+
+    bool Blend2DRenderer::SetCurrentFont(void* fontptr, float sz) override
+    {
+        currentFont = (BLFont*)fontptr;
+        return fontptr != nullptr;
+    }
+
+    void Blend2DRenderer::ResetFont()
+    {
+        currentFont = nullptr;
+    }
+
+    const Blend2DRenderer::GlyphRunData& Blend2DRenderer::ShapeText(std::string_view text, const BLFont& font)
+    {
+        auto hash = std::hash<std::string_view>()(text);
+        auto& run = _glyphRuns[GlyphRunKey{ text.data(), text.size(), &font }];
+
+        if (run.hash != hash || run.glyphs.empty())
+        {
+            BLTextMetrics metrics;
+            run.hash = hash;
+            run.glyphs.setUtf8Text(text.data(), text.size());
+            font.shape(run.glyphs);
+            font.getTextMetrics(run.glyphs, metrics);
+
+            auto& bb = metrics.boundingBox;
+            run.size = ImVec2{ (float)(bb.x1 - bb.x0), (float)(bb.y1 - bb.y0) };
+        }
+
+        return run;
+    }
+
+    ImVec2 Blend2DRenderer::GetTextSize(std::string_view text, void* fontptr, float sz)
+    {
+        IM_RICHTEXT_PROFILE_SCOPE(Measurement, text.size());
+        return ShapeText(text, *((BLFont*)fontptr)).size;
+    }
+
+    void Blend2DRenderer::DrawText(std::string_view text, ImVec2 pos, uint32_t color)
+    {
+        assert(currentFont != nullptr);
+        BLRgba32 rgba{ color };
+        context.setFillStyle(rgba);
+        context.fillGlyphRun(BLPoint{ pos.x, pos.y }, *currentFont, ShapeText(text, *currentFont).glyphs.glyphRun());
+    }
+
+    void Blend2DRenderer::DrawText(std::string_view text, std::string_view family, ImVec2 pos, float sz, uint32_t color, FontType type)
+    {
+        auto font = (BLFont*)GetFont(family, sz, type);
+        assert(font != nullptr);
+        BLRgba32 rgba{ color };
+        context.setFillStyle(rgba);
+        context.fillGlyphRun(BLPoint{ pos.x, pos.y }, *font, ShapeText(text, *font).glyphs.glyphRun());
+    }
+
+    void Blend2DRenderer::EvictTextCache(std::string_view source)
+    {
+        auto begin = _glyphRuns.lower_bound(GlyphRunKey{ source.data(), 0, nullptr });
+        auto end = _glyphRuns.lower_bound(GlyphRunKey{ source.data() + source.size(), 0, nullptr });
+        _glyphRuns.erase(begin, end);
+    }
+
+    void Blend2DRenderer::DrawTooltip(ImVec2 pos, std::string_view text)
+    {
+    }
+
+    ImVec2 Blend2DGlyphSource::GetTextSize(std::string_view text, void* fontptr, float sz)
+    {
+        BLGlyphBuffer glyphs;
+        BLTextMetrics metrics;
+        const auto& font = *((BLFont*)fontptr);
+        glyphs.setUtf8Text(text.data(), text.size());
+        font.shape(glyphs);
+        font.getTextMetrics(glyphs, metrics);
+
+        auto& bb = metrics.boundingBox;
+        return ImVec2{ (float)(bb.x1 - bb.x0), (float)(bb.y1 - bb.y0) };
+    }
+
+    float Blend2DGlyphSource::EllipsisWidth(void* fontptr, float sz)
+    {
+        return GetTextSize("...", fontptr, sz).x;
+    }
+
+    void Blend2DGlyphSource::RasterizeText(std::string_view text, void* fontptr, float sz, ImVec2 pos,
+        GlyphCoverage& coverage)
+    {
+        if (fontptr == nullptr) return;
+
+        // Glyphs may extend past the advance/ascent, hence the mask is padded by the font size
+        const auto& font = *((BLFont*)fontptr);
+        auto size = GetTextSize(text, fontptr, sz);
+        auto pad = std::ceil(font.size());
+        coverage.left = (int)std::floor(pos.x - pad);
+        coverage.top = (int)std::floor(pos.y - pad);
+        coverage.width = (int)std::ceil(size.x + 2.f * pad) + 1;
+        coverage.height = (int)std::ceil(size.y + 2.f * pad) + 1;
+
+        BLImage mask{ coverage.width, coverage.height, BL_FORMAT_A8 };
+        BLContext context{ mask };
+        context.clearAll();
+        context.setFillStyle(BLRgba32{ 0xFFFFFFFFu });
+        context.fillUtf8Text(BLPoint{ pos.x - (double)coverage.left, pos.y - (double)coverage.top }, font,
+            text.data(), text.size());
+        context.end();
+
+        BLImageData data;
+        mask.getData(&data);
+        coverage.alpha.resize((std::size_t)coverage.width * (std::size_t)coverage.height);
+
+        for (auto row = 0; row < coverage.height; ++row)
+            std::memcpy(coverage.alpha.data() + (std::size_t)row * (std::size_t)coverage.width,
+                (const unsigned char*)data.pixelData + (intptr_t)row * data.stride, (std::size_t)coverage.width);
+    }
+
+#endif
+
+    static uint32_t ScaleAlpha(uint32_t color, float factor)
+    {
+        auto alpha = (float)((color & IM_COL32_A_MASK) >> IM_COL32_A_SHIFT) * std::min(std::max(factor, 0.f), 1.f);
+        return (color & ~IM_COL32_A_MASK) | ((uint32_t)(alpha + 0.5f) << IM_COL32_A_SHIFT);
+    }
+
+    // Source-over blending of straight alpha colors, the destination alpha is blended 
+    // as if the source were opaque, which yields a + da * (1 - a)
+    static uint32_t BlendColor(uint32_t dst, uint32_t src, uint32_t alpha)
+    {
+        auto inv = 255u - alpha;
+        src |= IM_COL32_A_MASK;
+        uint32_t result = 0;
+
+        for (auto shift = 0; shift < 32; shift += 8)
+        {
+            auto value = ((src >> shift) & 0xFF) * alpha + ((dst >> shift) & 0xFF) * inv + 128u;
+            result |= (((value + (value >> 8)) >> 8) & 0xFF) << shift;
+        }
+
+        return result;
     }
 
-    float ImGuiRenderer::EllipsisWidth(void* fontptr, float sz)
+    // Signed distance (positive outside) to a rect with per-corner radius
+    static float RoundedRectDistance(ImVec2 pos, ImVec2 center, ImVec2 halfsz, const float* radii)
     {
-        return ((ImFont*)fontptr)->EllipsisWidth;
+        auto dx = pos.x - center.x, dy = pos.y - center.y;
+        auto r = dy < 0.f ? (dx < 0.f ? radii[TopLeftCorner] : radii[TopRightCorner]) :
+            (dx < 0.f ? radii[BottomLeftCorner] : radii[BottomRightCorner]);
+        auto qx = std::fabs(dx) - halfsz.x + r, qy = std::fabs(dy) - halfsz.y + r;
+        auto ox = std::max(qx, 0.f), oy = std::max(qy, 0.f);
+        return std::sqrt(ox * ox + oy * oy) + std::min(std::max(qx, qy), 0.f) - r;
     }
 
-    ImVec2 ImGuiPlatform::GetCurrentMousePos()
+    static float SegmentDistance(ImVec2 pos, ImVec2 from, ImVec2 to)
     {
-        return ImGui::GetIO().MousePos;
+        auto dx = to.x - from.x, dy = to.y - from.y;
+        auto len2 = dx * dx + dy * dy;
+        auto t = len2 > 0.f ? std::min(std::max(((pos.x - from.x) * dx + (pos.y - from.y) * dy) / len2, 0.f), 1.f) : 0.f;
+        auto px = from.x + dx * t - pos.x, py = from.y + dy * t - pos.y;
+        return std::sqrt(px * px + py * py);
     }
 
-    bool ImGuiPlatform::IsMouseClicked()
+    SoftwareRenderer::SoftwareRenderer(IGlyphSource& source, int w, int h)
+        : glyphs{ source }, width{ std::max(w, 0) }, height{ std::max(h, 0) }, 
+        pixels((std::size_t)width * (std::size_t)height, 0u),
+        _clip{ 0, 0, width, height }
+    {}
+
+    void SoftwareRenderer::SetClipRect(ImVec2 startpos, ImVec2 endpos)
     {
-        return ImGui::GetIO().MouseReleased[0];
+        _clipStack.push_back(_clip);
+        _clip.left = std::max(_clip.left, (int)std::floor(startpos.x));
+        _clip.top = std::max(_clip.top, (int)std::floor(startpos.y));
+        _clip.right = std::min(_clip.right, (int)std::floor(endpos.x + 0.999f));
+        _clip.bottom = std::min(_clip.bottom, (int)std::floor(endpos.y + 0.999f));
     }
 
-    void ImGuiPlatform::HandleHyperlink(std::string_view link)
+    void SoftwareRenderer::ResetClipRect()
     {
-        if (HyperlinkClicked != nullptr)
-            HyperlinkClicked(link);
+        if (!_clipStack.empty())
+        {
+            _clip = _clipStack.back();
+            _clipStack.pop_back();
+        }
     }
 
-    void ImGuiPlatform::HandleHover(bool hovered)
+    void SoftwareRenderer::BlendSpan(int y, int startx, int endx, uint32_t color)
     {
-        hovered ? ImGui::SetMouseCursor(ImGuiMouseCursor_Hand) :
-            ImGui::SetMouseCursor(ImGuiMouseCursor_Arrow);
-    }
+        startx = std::max(startx, _clip.left);
+        endx = std::min(endx, _clip.right);
+        if (y < _clip.top || y >= _clip.bottom || startx >= endx) return;
 
+        auto alpha = (color & IM_COL32_A_MASK) >> IM_COL32_A_SHIFT;
+        auto row = pixels.data() + (std::size_t)y * (std::size_t)width;
+        if (alpha == 0u) return;
+
+        if (alpha == 255u)
+        {
+            std::fill(row + startx, row + endx, color);
+            return;
+        }
+
+        auto x = startx;
+
+#ifdef IM_RICHTEXT_SOFTWARE_SSE2
+        // Blend 4 pixels at a time, with 16-bit lanes per channel
+        const auto zero = _mm_setzero_si128();
+        const auto src = _mm_unpacklo_epi8(_mm_set1_epi32((int)(color | IM_COL32_A_MASK)), zero);
+        const auto inv = _mm_set1_epi16((short)(255u - alpha));
+        const auto srcmul = _mm_add_epi16(_mm_mullo_epi16(src, _mm_set1_epi16((short)alpha)), _mm_set1_epi16(128));
+
+        for (; x + 4 <= endx; x += 4)
+        {
+            auto dst = _mm_loadu_si128((const __m128i*)(row + x));
+            auto lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(dst, zero), inv), srcmul);
+            auto hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(dst, zero), inv), srcmul);
+            lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+            hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+            _mm_storeu_si128((__m128i*)(row + x), _mm_packus_epi16(lo, hi));
+        }
 #endif
-#ifdef IM_RICHTEXT_TARGET_BLEND2D
 
-    Blend2DRenderer::Blend2DRenderer(BLContext& ctx) : context{ ctx } {}
+        for (; x < endx; ++x)
+            row[x] = BlendColor(row[x], color, alpha);
+    }
 
-    void Blend2DRenderer::SetClipRect(ImVec2 startpos, ImVec2 endpos)
+    void SoftwareRenderer::BlendPixel(int x, int y, uint32_t color, float coverage)
     {
-        context.clipToRect(BLRect{ startpos.x, startpos.y, endpos.x - startpos.x, endpos.y - startpos.y });
+        if (coverage <= 0.f || x < _clip.left || x >= _clip.right ||
+            y < _clip.top || y >= _clip.bottom) return;
+
+        auto alpha = (uint32_t)((float)((color & IM_COL32_A_MASK) >> IM_COL32_A_SHIFT) * std::min(coverage, 1.f) + 0.5f);
+        auto& pixel = pixels[(std::size_t)y * (std::size_t)width + (std::size_t)x];
+        if (alpha > 0u) pixel = BlendColor(pixel, color, alpha);
     }
 
-    void Blend2DRenderer::ResetClipRect()
+    // Axis aligned rect with fractional coverage along the edges
+    void SoftwareRenderer::FillRect(ImVec2 startpos, ImVec2 endpos, uint32_t color)
     {
-        context.restoreClipping();
+        auto starty = std::max((int)std::floor(startpos.y), _clip.top);
+        auto endy = std::min((int)std::ceil(endpos.y), _clip.bottom);
+        auto left = (int)std::floor(startpos.x), right = (int)std::ceil(endpos.x) - 1;
+
+        for (auto y = starty; y < endy; ++y)
+        {
+            auto ycoverage = std::min((float)y + 1.f, endpos.y) - std::max((float)y, startpos.y);
+            if (ycoverage <= 0.f) continue;
+
+            if (left == right)
+            {
+                BlendPixel(left, y, color, ycoverage * (endpos.x - startpos.x));
+                continue;
+            }
+
+            BlendPixel(left, y, color, ycoverage * ((float)left + 1.f - startpos.x));
+            BlendSpan(y, left + 1, right, ycoverage >= 1.f ? color : ScaleAlpha(color, ycoverage));
+            BlendPixel(right, y, color, ycoverage * (endpos.x - (float)right));
+        }
     }
 
-    void Blend2DRenderer::DrawLine(ImVec2 startpos, ImVec2 endpos, uint32_t color, float thickness)
+    // Evaluates coverage per pixel in the bounding rect, except for rows which are entirely 
+    // within `innermin`-`innermax`, where the inner span is filled directly (or skipped if hollow)
+    template <typename CoverageT>
+    void SoftwareRenderer::FillCoverage(ImVec2 startpos, ImVec2 endpos, ImVec2 innermin, ImVec2 innermax, bool hollow,
+        uint32_t color, CoverageT coverage)
     {
-        BLLine line;
-        line.x0 = startpos.x;
-        line.x1 = endpos.x;
-        line.y0 = startpos.y;
-        line.y1 = endpos.y;
+        auto starty = std::max((int)std::floor(startpos.y), _clip.top);
+        auto endy = std::min((int)std::ceil(endpos.y), _clip.bottom);
+        auto startx = std::max((int)std::floor(startpos.x), _clip.left);
+        auto endx = std::min((int)std::ceil(endpos.x), _clip.right);
 
-        BLRgba32 rgba{ color };
-        context.setStrokeWidth(thickness);
-        context.setStrokeStyle(rgba);
-        context.strokeLine(line);
+        for (auto y = starty; y < endy; ++y)
+        {
+            auto spanstart = endx, spanend = endx;
+
+            if ((float)y >= innermin.y && (float)y + 1.f <= innermax.y)
+            {
+                spanstart = std::max((int)std::ceil(innermin.x), startx);
+                spanend = std::max((int)std::floor(innermax.x), spanstart);
+            }
+
+            for (auto x = startx; x < endx; ++x)
+            {
+                if (x == spanstart && spanstart < spanend)
+                {
+                    if (!hollow) BlendSpan(y, spanstart, spanend, color);
+                    x = spanend - 1;
+                    continue;
+                }
+
+                BlendPixel(x, y, color, coverage(ImVec2{ (float)x + 0.5f, (float)y + 0.5f }));
+            }
+        }
     }
 
-    void Blend2DRenderer::DrawPolyline(ImVec2* points, int sz, uint32_t color, float thickness)
+    // Pixels are included if their center lies inside the triangle, with the usual top-left
+    // rule for centers on an edge, so that adjacent triangles of a mesh are not blended twice
+    void SoftwareRenderer::FillTriangle(const ImVec2* points, const uint32_t* colors)
     {
-        thread_local static BLPoint blpoints[64];
-        assert(sz < 64);
-        std::memset(points, 0, sizeof(BLPoint) * 64);
-        for (auto idx = 0; idx < sz; ++idx) {
-            blpoints[idx].x = points[idx].x;
-            blpoints[idx].y = points[idx].y;
+        auto edge = [](ImVec2 a, ImVec2 b, ImVec2 p) { return (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x); };
+        int order[3] = { 0, 1, 2 };
+        auto area = edge(points[0], points[1], points[2]);
+        if (std::fabs(area) < 0.0001f) return;
+        if (area < 0.f) { std::swap(order[1], order[2]); area = -area; }
+
+        const ImVec2 p[3] = { points[order[0]], points[order[1]], points[order[2]] };
+        float channels[3][4];
+        bool topleft[3];
+
+        for (auto vtx = 0; vtx < 3; ++vtx)
+        {
+            for (auto ch = 0; ch < 4; ++ch)
+                channels[vtx][ch] = (float)((colors[order[vtx]] >> (ch * 8)) & 0xFF);
+
+            // Edge opposite to vertex `vtx`, interior lies on its positive side
+            auto from = p[(vtx + 1) % 3], to = p[(vtx + 2) % 3];
+            auto dx = to.x - from.x, dy = to.y - from.y;
+            topleft[vtx] = (dy == 0.f && dx > 0.f) || dy < 0.f;
         }
 
-        BLRgba32 rgba{ color };
-        context.setStrokeWidth(thickness);
-        context.setStrokeStyle(rgba);
-        context.strokePolyline(blpoints, sz);
+        auto starty = std::max((int)std::floor(std::min({ p[0].y, p[1].y, p[2].y })), _clip.top);
+        auto endy = std::min((int)std::ceil(std::max({ p[0].y, p[1].y, p[2].y })), _clip.bottom);
+        auto startx = std::max((int)std::floor(std::min({ p[0].x, p[1].x, p[2].x })), _clip.left);
+        auto endx = std::min((int)std::ceil(std::max({ p[0].x, p[1].x, p[2].x })), _clip.right);
+
+        for (auto y = starty; y < endy; ++y)
+        {
+            for (auto x = startx; x < endx; ++x)
+            {
+                ImVec2 center{ (float)x + 0.5f, (float)y + 0.5f };
+                float weights[3];
+                auto inside = true;
+
+                for (auto vtx = 0; vtx < 3 && inside; ++vtx)
+                {
+                    weights[vtx] = edge(p[(vtx + 1) % 3], p[(vtx + 2) % 3], center);
+                    inside = weights[vtx] > 0.f || (weights[vtx] == 0.f && topleft[vtx]);
+                }
+
+                if (!inside) continue;
+
+                uint32_t color = 0;
+                for (auto ch = 0; ch < 4; ++ch)
+                {
+                    auto value = (weights[0] * channels[0][ch] + weights[1] * channels[1][ch] +
+                        weights[2] * channels[2][ch]) / area;
+                    color |= ((uint32_t)std::min(std::max(value + 0.5f, 0.f), 255.f)) << (ch * 8);
+                }
+
+                BlendPixel(x, y, color, 1.f);
+            }
+        }
     }
 
-    void Blend2DRenderer::DrawTriangle(ImVec2 pos1, ImVec2 pos2, ImVec2 pos3, uint32_t color, bool filled, bool thickness)
+    void SoftwareRenderer::DrawLine(ImVec2 startpos, ImVec2 endpos, uint32_t color, float thickness)
     {
-        BLRgba32 rgba{ color };
-        context.setStrokeWidth(thickness);
-        context.setStrokeStyle(rgba);
-        if (filled) context.setFillStyle(rgba);
-        else context.setFillStyle(IM_COL32_BLACK_TRANS);
-        context.strokeTriangle(pos1.x, pos1.y, pos2.x, pos2.y, pos3.x, pos3.y);
+        // Lines are centered on pixels, same as ImDrawList::AddLine
+        auto half = thickness * 0.5f;
+        startpos = startpos + ImVec2{ 0.5f, 0.5f };
+        endpos = endpos + ImVec2{ 0.5f, 0.5f };
+
+        if (startpos.y == endpos.y)
+            FillRect(ImVec2{ std::min(startpos.x, endpos.x), startpos.y - half },
+                ImVec2{ std::max(startpos.x, endpos.x), startpos.y + half }, color);
+        else if (startpos.x == endpos.x)
+            FillRect(ImVec2{ startpos.x - half, std::min(startpos.y, endpos.y) },
+                ImVec2{ startpos.x + half, std::max(startpos.y, endpos.y) }, color);
+        else
+        {
+            ImVec2 min{ std::min(startpos.x, endpos.x) - half - 1.f, std::min(startpos.y, endpos.y) - half - 1.f };
+            ImVec2 max{ std::max(startpos.x, endpos.x) + half + 1.f, std::max(startpos.y, endpos.y) + half + 1.f };
+            FillCoverage(min, max, ImVec2{}, ImVec2{}, false, color, [&](ImVec2 pos) {
+                return std::min(half + 0.5f - SegmentDistance(pos, startpos, endpos), 1.f);
+            });
+        }
     }
 
-    void Blend2DRenderer::DrawRect(ImVec2 startpos, ImVec2 endpos, uint32_t color, bool filled, float thickness)
+    void SoftwareRenderer::DrawPolyline(ImVec2* points, int sz, uint32_t color, float thickness)
     {
-        BLRgba32 rgba{ color };
-        context.setStrokeWidth(thickness);
-        context.setStrokeStyle(rgba);
-        if (filled) context.setFillStyle(rgba);
-        else context.setFillStyle(IM_COL32_BLACK_TRANS);
-        context.strokeRect(startpos.x, startpos.y, endpos.x - startpos.x, endpos.y - startpos.y);
+        for (auto idx = 0; idx + 1 < sz; ++idx)
+            DrawLine(points[idx], points[idx + 1], color, thickness);
     }
 
-    void Blend2DRenderer::DrawRectGradient(ImVec2 startpos, ImVec2 endpos, uint32_t topleftcolor, uint32_t toprightcolor, uint32_t bottomrightcolor, uint32_t bottomleftcolor)
+    void SoftwareRenderer::DrawTriangle(ImVec2 pos1, ImVec2 pos2, ImVec2 pos3, uint32_t color, bool filled, bool thickness)
     {
-        BLGradient gradient;
-        gradient.setType(BLGradientType::BL_GRADIENT_TYPE_LINEAR);
-        gradient.setX0(startpos.x);
-        gradient.setX1(endpos.x);
-        gradient.setY0(startpos.y);
-        gradient.setY1(endpos.y);
-        gradient.addStop(0.f, BLRgba32{ topleftcolor });
-        gradient.addStop(1.f, BLRgba32{ bottomrightcolor });
-        context.setFillStyle(gradient);
-        context.strokeRect(startpos.x, startpos.y, endpos.x - startpos.x, endpos.y - startpos.y);
+        ImVec2 points[3] = { pos1, pos2, pos3 };
+        DrawPolygon(points, 3, color, filled, 1.f);
     }
 
-    void Blend2DRenderer::DrawRoundedRect(ImVec2 startpos, ImVec2 endpos, uint32_t color, bool filled, float topleftr, float toprightr, float bottomrightr, float bottomleftr, float thickness)
+    void SoftwareRenderer::DrawRect(ImVec2 startpos, ImVec2 endpos, uint32_t color, bool filled, float thickness)
     {
-        auto isUniformRadius = toprightr == toprightr && toprightr == bottomrightr && bottomrightr == bottomleftr;
-        BLRgba32 rgba{ color };
-        context.setStrokeWidth(thickness);
-        context.setStrokeStyle(rgba);
-        if (filled) context.setFillStyle(rgba);
-        else context.setFillStyle(IM_COL32_BLACK_TRANS);
+        if (filled)
+            FillRect(startpos, endpos, color);
+        else if (thickness > 0.f)
+        {
+            // Stroke is centered on the half pixel inset rect, same as ImDrawList::AddRect
+            auto outer = 0.5f - thickness * 0.5f, inner = 0.5f + thickness * 0.5f;
+            FillRect(startpos + ImVec2{ outer, outer }, ImVec2{ endpos.x - outer, startpos.y + inner }, color);
+            FillRect(ImVec2{ startpos.x + outer, endpos.y - inner }, endpos - ImVec2{ outer, outer }, color);
+            FillRect(ImVec2{ startpos.x + outer, startpos.y + inner }, ImVec2{ startpos.x + inner, endpos.y - inner }, color);
+            FillRect(ImVec2{ endpos.x - inner, startpos.y + inner }, ImVec2{ endpos.x - outer, endpos.y - inner }, color);
+        }
+    }
 
-        if (isUniformRadius)
+    void SoftwareRenderer::DrawRoundedRect(ImVec2 startpos, ImVec2 endpos, uint32_t color, bool filled, 
+        float topleftr, float toprightr, float bottomrightr, float bottomleftr, float thickness)
+    {
+        if (!filled)
         {
-            context.strokeRoundedRect(startpos.x, startpos.y, endpos.x - startpos.x, endpos.y - startpos.y, topleftr, bottomrightr);
+            startpos = startpos + ImVec2{ 0.5f, 0.5f };
+            endpos = endpos - ImVec2{ 0.5f, 0.5f };
         }
+
+        auto halfsz = (endpos - startpos) * 0.5f;
+        auto center = startpos + halfsz;
+        auto maxradius = std::max(std::min(halfsz.x, halfsz.y), 0.f);
+        float radii[4];
+        radii[TopLeftCorner] = std::min(topleftr, maxradius);
+        radii[TopRightCorner] = std::min(toprightr, maxradius);
+        radii[BottomRightCorner] = std::min(bottomrightr, maxradius);
+        radii[BottomLeftCorner] = std::min(bottomleftr, maxradius);
+
+        // Rows between the corners have straight sides, and are filled/skipped directly
+        auto half = filled ? 0.f : thickness * 0.5f;
+        auto pad = filled ? 1.f : half + 1.f;
+        ImVec2 innermin{ startpos.x + pad, startpos.y + std::max(std::max(radii[TopLeftCorner], radii[TopRightCorner]) + half, pad) };
+        ImVec2 innermax{ endpos.x - pad, endpos.y - std::max(std::max(radii[BottomLeftCorner], radii[BottomRightCorner]) + half, pad) };
+
+        if (filled)
+            FillCoverage(startpos, endpos, innermin, innermax, false, color, [&](ImVec2 pos) {
+                return std::min(0.5f - RoundedRectDistance(pos, center, halfsz, radii), 1.f);
+            });
         else
+            FillCoverage(startpos - ImVec2{ half + 1.f, half + 1.f }, endpos + ImVec2{ half + 1.f, half + 1.f }, innermin, innermax, true, 
+                color, [&](ImVec2 pos) {
+                return std::min(half + 0.5f - std::fabs(RoundedRectDistance(pos, center, halfsz, radii)), 1.f);
+            });
+    }
+
+    void SoftwareRenderer::DrawRectGradient(ImVec2 startpos, ImVec2 endpos, uint32_t topleftcolor, uint32_t toprightcolor, uint32_t bottomrightcolor, uint32_t bottomleftcolor)
+    {
+        auto width = endpos.x - startpos.x, height = endpos.y - startpos.y;
+        if (width <= 0.f || height <= 0.f) return;
+
+        auto starty = std::max((int)std::floor(startpos.y), _clip.top);
+        auto endy = std::min((int)std::ceil(endpos.y), _clip.bottom);
+        auto startx = std::max((int)std::floor(startpos.x), _clip.left);
+        auto endx = std::min((int)std::ceil(endpos.x), _clip.right);
+
+        for (auto y = starty; y < endy; ++y)
         {
-            BLPath path;
-            path.moveTo(startpos.x, endpos.y - bottomleftr);
-            path.lineTo(startpos.x, startpos.y + topleftr);
-            if (topleftr > 0.f) path.arcTo(startpos.x + topleftr, startpos.y + topleftr, topleftr, topleftr, M_PI, 1.5 * M_PI);
-            path.lineTo(endpos.x - toprightr, startpos.y);
-            if (toprightr > 0.f) path.arcTo(endpos.x - toprightr, startpos.y + toprightr, toprightr, toprightr, 1.5 * M_PI, 2.0 * M_PI);
-            path.lineTo(endpos.x, endpos.y - bottomrightr);
-            if (bottomrightr > 0.f) path.arcTo(endpos.x - bottomrightr, endpos.y - bottomrightr, bottomrightr, bottomrightr, 0.0, 0.5 * M_PI);
-            path.lineTo(startpos.x - bottomleftr, endpos.y);
-            if (bottomleftr > 0.f) path.arcTo(startpos.x + bottomleftr, endpos.y - bottomleftr, bottomleftr, bottomleftr, 0.5 * M_PI, M_PI);
+            auto v = std::min(std::max(((float)y + 0.5f - startpos.y) / height, 0.f), 1.f);
+            auto left = LerpColor(topleftcolor, bottomleftcolor, v);
+            auto right = LerpColor(toprightcolor, bottomrightcolor, v);
 
-            context.strokePath(path);
+            if (left == right)
+                BlendSpan(y, startx, endx, left);
+            else
+                for (auto x = startx; x < endx; ++x)
+                    BlendPixel(x, y, LerpColor(left, right, std::min(std::max(((float)x + 0.5f - startpos.x) / width, 0.f), 1.f)), 1.f);
         }
     }
 
-    void Blend2DRenderer::DrawPolygon(ImVec2* points, int sz, uint32_t color, bool filled, float thickness)
+    void SoftwareRenderer::DrawPolygon(ImVec2* points, int sz, uint32_t color, bool filled, float thickness)
     {
-        thread_local static BLPoint blpoints[64];
-        assert(sz < 64);
-        std::memset(points, 0, sizeof(BLPoint) * 64);
-        for (auto idx = 0; idx < sz; ++idx) {
-            blpoints[idx].x = points[idx].x;
-            blpoints[idx].y = points[idx].y;
+        if (sz < 2) return;
+
+        if (!filled)
+        {
+            DrawPolyline(points, sz, color, thickness);
+            DrawLine(points[sz - 1], points[0], color, thickness);
+            return;
         }
 
-        BLRgba32 rgba{ color };
-        context.setStrokeWidth(thickness);
-        context.setStrokeStyle(rgba);
-        if (filled) context.setFillStyle(rgba);
-        else context.setFillStyle(IM_COL32_BLACK_TRANS);
-        context.strokePolygon(blpoints, sz);
+        // Convex polygons only, coverage is derived from the farthest edge
+        ImVec2 min = points[0], max = points[0];
+        auto area = 0.f;
+
+        for (auto idx = 0, prev = sz - 1; idx < sz; prev = idx++)
+        {
+            min = ImVec2{ std::min(min.x, points[idx].x), std::min(min.y, points[idx].y) };
+            max = ImVec2{ std::max(max.x, points[idx].x), std::max(max.y, points[idx].y) };
+            area += points[prev].x * points[idx].y - points[idx].x * points[prev].y;
+        }
+
+        auto orientation = area < 0.f ? -1.f : 1.f;
+        FillCoverage(min - ImVec2{ 1.f, 1.f }, max + ImVec2{ 1.f, 1.f }, ImVec2{}, ImVec2{}, false, color, [&](ImVec2 pos) {
+            auto distance = -FLT_MAX;
+            for (auto idx = 0, prev = sz - 1; idx < sz; prev = idx++)
+            {
+                auto normal = EdgeNormal(points[prev], points[idx]) * orientation;
+                distance = std::max(distance, (pos.x - points[idx].x) * normal.x + (pos.y - points[idx].y) * normal.y);
+            }
+            return std::min(0.5f - distance, 1.f);
+        });
     }
 
-    void Blend2DRenderer::DrawPolyGradient(ImVec2* points, uint32_t* colors, int sz)
+    void SoftwareRenderer::DrawPolyGradient(ImVec2* points, uint32_t* colors, int sz)
     {
-        // TODO: figure this out...
+        for (auto idx = 2; idx < sz; ++idx)
+        {
+            const ImVec2 triangle[3] = { points[0], points[idx - 1], points[idx] };
+            const uint32_t vtxcolors[3] = { colors[0], colors[idx - 1], colors[idx] };
+            FillTriangle(triangle, vtxcolors);
+        }
     }
 
-    void Blend2DRenderer::DrawCircle(ImVec2 center, float radius, uint32_t color, bool filled, bool thickness)
+    void SoftwareRenderer::DrawCircle(ImVec2 center, float radius, uint32_t color, bool filled, bool thickness)
     {
-        BLRgba32 rgba{ color };
-        context.setStrokeWidth(thickness);
-        context.setStrokeStyle(rgba);
-        if (filled) context.setFillStyle(rgba);
-        else context.setFillStyle(IM_COL32_BLACK_TRANS);
-        context.strokeCircle(center.x, center.y, radius);
+        auto extent = ImVec2{ radius + 1.f, radius + 1.f };
+
+        if (filled)
+        {
+            auto inset = std::max(radius * 0.7071f - 1.f, 0.f);
+            FillCoverage(center - extent, center + extent, center - ImVec2{ inset, inset }, center + ImVec2{ inset, inset },
+                false, color, [&](ImVec2 pos) { return std::min(radius + 0.5f - std::hypot(pos.x - center.x, pos.y - center.y), 1.f); });
+        }
+        else
+        {
+            // Stroke is centered half a pixel inside, same as ImDrawList::AddCircle
+            auto inset = std::max((radius - 2.f) * 0.7071f, 0.f);
+            FillCoverage(center - extent, center + extent, center - ImVec2{ inset, inset }, center + ImVec2{ inset, inset },
+                true, color, [&](ImVec2 pos) { return std::min(1.f - std::fabs(std::hypot(pos.x - center.x, pos.y - center.y) - radius + 0.5f), 1.f); });
+        }
     }
 
-    void Blend2DRenderer::DrawRadialGradient(ImVec2 center, float radius, uint32_t in, uint32_t out, int start, int end)
+    void SoftwareRenderer::DrawRadialGradient(ImVec2 center, float radius, uint32_t in, uint32_t out, int start, int end)
     {
-        BLGradient gradient;
-        gradient.setType(BLGradientType::BL_GRADIENT_TYPE_RADIAL);
-        gradient.setX0(startpos.x);
-        gradient.setX1(startpos.x);
-        gradient.setY0(startpos.y);
-        gradient.setY1(startpos.y);
-        gradient.setR0(radius);
-        gradient.setR1(radius);
-        gradient.addStop(0.f, BLRgba32{ in });
-        gradient.addStop(1.f, BLRgba32{ out });
-        context.setFillStyle(gradient);
-        context.strokeCircle(startpos.x, startpos.y, radius);
+        if (((in | out) & IM_COL32_A_MASK) == 0 || radius < 0.5f)
+            return;
+
+        auto starty = std::max((int)std::floor(center.y - radius), _clip.top);
+        auto endy = std::min((int)std::ceil(center.y + radius), _clip.bottom);
+        auto startx = std::max((int)std::floor(center.x - radius), _clip.left);
+        auto endx = std::min((int)std::ceil(center.x + radius), _clip.right);
+
+        for (auto y = starty; y < endy; ++y)
+        {
+            for (auto x = startx; x < endx; ++x)
+            {
+                auto dx = (float)x + 0.5f - center.x, dy = (float)y + 0.5f - center.y;
+                auto distance = std::sqrt(dx * dx + dy * dy);
+                auto angle = std::atan2(dy, dx) * (180.f / (float)M_PI);
+                if (angle < 0.f) angle += 360.f;
+                if (distance > radius + 0.5f || ((angle < (float)start || angle > (float)end) &&
+                    (angle + 360.f < (float)start || angle + 360.f > (float)end))) continue;
+
+                BlendPixel(x, y, LerpColor(in, out, std::min(distance / radius, 1.f)), radius + 0.5f - distance);
+            }
+        }
     }
 
-    bool Blend2DRenderer::SetCurrentFont(std::string_view family, float sz, FontType type) override
+    void SoftwareRenderer::DrawMesh(const ImVec2* positions, const uint32_t* colors, int vtxcount,
+        const uint32_t* indices, int idxcount, ImVec2 offset)
     {
-        currentFont = GetFont(family, sz, type);
-        return currentFont != nullptr;
+        ImVec2 triangle[3];
+        uint32_t vtxcolors[3];
+
+        for (auto idx = 0; idx + 2 < idxcount; idx += 3)
+        {
+            for (auto vtx = 0; vtx < 3; ++vtx)
+            {
+                triangle[vtx] = positions[indices[idx + vtx]] + offset;
+                vtxcolors[vtx] = colors[indices[idx + vtx]];
+            }
+
+            FillTriangle(triangle, vtxcolors);
+        }
     }
 
-    bool Blend2DRenderer::SetCurrentFont(void* fontptr, float sz) override
+    bool SoftwareRenderer::SetCurrentFont(std::string_view family, float sz, FontType type)
     {
-        currentFont = (BLFont*)fontptr;
-        return fontptr != nullptr;
+        return SetCurrentFont(GetFont(family, sz, type), sz);
     }
 
-    void Blend2DRenderer::ResetFont()
+    bool SoftwareRenderer::SetCurrentFont(void* fontptr, float sz)
     {
-        currentFont = nullptr;
+        if (fontptr != nullptr)
+        {
+            _fonts.emplace_back(fontptr, sz);
+            return true;
+        }
+
+        return false;
     }
 
-    ImVec2 Blend2DRenderer::GetTextSize(std::string_view text, void* fontptr, float sz)
+    void SoftwareRenderer::ResetFont()
     {
-        auto& font = *((BLFont*)fontptr);
-        BLGlyphBuffer buf;
-        BLTextMetrics metrics;
-        buf.setUtf8Text(text.data(), text.size());
-        font.shape(buf);
-        font.getTextMetrics(buf, metrics);
+        if (!_fonts.empty()) _fonts.pop_back();
+    }
 
-        auto& bb = metrics.boundingBox;
-        return ImVec2{ bb.x1 - bb.x0, bb.y1 - bb.y0 };
+    ImVec2 SoftwareRenderer::GetTextSize(std::string_view text, void* fontptr, float sz)
+    {
+        IM_RICHTEXT_PROFILE_SCOPE(Measurement, text.size());
+        return glyphs.GetTextSize(text, fontptr, sz);
     }
 
-    void Blend2DRenderer::DrawText(std::string_view text, ImVec2 pos, uint32_t color)
+    void SoftwareRenderer::DrawGlyphs(std::string_view text, void* font, float sz, ImVec2 pos, uint32_t color)
     {
-        assert(currentFont != nullptr);
-        BLRgba32 rgba{ color };
-        context.setFillStyle(rgba);
-        context.fillUtf8Text(BLPoint{ pos.x, pos.y }, *currentFont, BLStringView{ text.data(), text.size() });
+        if (font == nullptr || (color & IM_COL32_A_MASK) == 0) return;
+
+        _coverage.width = _coverage.height = 0;
+        glyphs.RasterizeText(text, font, sz, pos, _coverage);
+
+        auto starty = std::max(_coverage.top, _clip.top);
+        auto endy = std::min(_coverage.top + _coverage.height, _clip.bottom);
+        auto startx = std::max(_coverage.left, _clip.left);
+        auto endx = std::min(_coverage.left + _coverage.width, _clip.right);
+
+        for (auto y = starty; y < endy; ++y)
+        {
+            auto row = _coverage.alpha.data() + (std::size_t)(y - _coverage.top) * (std::size_t)_coverage.width;
+
+            for (auto x = startx; x < endx; ++x)
+                if (row[x - _coverage.left] != 0) 
+                    BlendPixel(x, y, color, (float)row[x - _coverage.left] * (1.f / 255.f));
+        }
     }
 
-    void Blend2DRenderer::DrawText(std::string_view text, std::string_view family, ImVec2 pos, float sz, uint32_t color, FontType type)
+    void SoftwareRenderer::DrawText(std::string_view text, ImVec2 pos, uint32_t color)
     {
-        auto font = GetFont(family, sz, type);
-        assert(font != nullptr);
-        BLRgba32 rgba{ color };
-        context.setFillStyle(rgba);
-        context.fillUtf8Text(BLPoint{ pos.x, pos.y }, *font, BLStringView{ text.data(), text.size() });
+        if (!_fonts.empty())
+            DrawGlyphs(text, _fonts.back().first, _fonts.back().second, pos, color);
     }
 
-    void Blend2DRenderer::DrawTooltip(ImVec2 pos, std::string_view text)
+    void SoftwareRenderer::DrawText(std::string_view text, std::string_view family, ImVec2 pos, float sz, uint32_t color, FontType type)
     {
+        DrawGlyphs(text, GetFont(family, sz, type), sz, pos, color);
+    }
+
+    void SoftwareRenderer::DrawTooltip(ImVec2 pos, std::string_view text)
+    {
+        // There is no hover state when rendering offscreen
+    }
+
+    float SoftwareRenderer::EllipsisWidth(void* fontptr, float sz)
+    {
+        return glyphs.EllipsisWidth(fontptr, sz);
     }
 
-#endif
 }
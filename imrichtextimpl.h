@@ -5,9 +5,14 @@
 #endif
 #ifdef IM_RICHTEXT_TARGET_BLEND2D
 #include <blend2d.h>
+#include <map>
+#include <tuple>
 #endif
 #include "imrichtextutils.h"
 
+#include <cstdio>
+#include <string>
+
 namespace ImRichText
 {
     struct RenderConfig;
@@ -48,6 +53,134 @@ namespace ImRichText
         static const std::pair<std::string_view, std::string_view> EscapeCodes[11];
     };
 
+    // Tessellates shapes into a mesh instead of drawing them, so that the result can be
+    // submitted later through IRenderer::DrawMesh. Text is not recorded.
+    struct MeshRecorder final : public IRenderer
+    {
+        MeshData& mesh;
+
+        MeshRecorder(MeshData&);
+
+        void SetClipRect(ImVec2 startpos, ImVec2 endpos);
+        void ResetClipRect();
+
+        void DrawLine(ImVec2 startpos, ImVec2 endpos, uint32_t color, float thickness = 1.f);
+        void DrawPolyline(ImVec2* points, int sz, uint32_t color, float thickness);
+        void DrawTriangle(ImVec2 pos1, ImVec2 pos2, ImVec2 pos3, uint32_t color, bool filled, bool thickness = 1.f);
+        void DrawRect(ImVec2 startpos, ImVec2 endpos, uint32_t color, bool filled, float thickness = 1.f);
+        void DrawRoundedRect(ImVec2 startpos, ImVec2 endpos, uint32_t color, bool filled, float topleftr, float toprightr, float bottomrightr, float bottomleftr, float thickness = 1.f);
+        void DrawRectGradient(ImVec2 startpos, ImVec2 endpos, uint32_t topleftcolor, uint32_t toprightcolor, uint32_t bottomrightcolor, uint32_t bottomleftcolor);
+        void DrawPolygon(ImVec2* points, int sz, uint32_t color, bool filled, float thickness = 1.f);
+        void DrawPolyGradient(ImVec2* points, uint32_t* colors, int sz);
+        void DrawCircle(ImVec2 center, float radius, uint32_t color, bool filled, bool thickness = 1.f);
+        void DrawRadialGradient(ImVec2 center, float radius, uint32_t in, uint32_t out, int start, int end);
+        void DrawMesh(const ImVec2* positions, const uint32_t* colors, int vtxcount,
+            const uint32_t* indices, int idxcount, ImVec2 offset) override;
+        [[nodiscard]] bool SupportsMeshes() const override { return true; }
+
+        [[nodiscard]] ImVec2 GetTextSize(std::string_view text, void* fontptr, float sz);
+        void DrawText(std::string_view text, ImVec2 pos, uint32_t color);
+        void DrawText(std::string_view text, std::string_view family, ImVec2 pos, float sz, uint32_t color, FontType type);
+        void DrawTooltip(ImVec2 pos, std::string_view text);
+
+    private:
+        void AddTriangles(const ImVec2* positions, const uint32_t* colors, int vtxcount,
+            const uint32_t* indices, int idxcount, ImVec2 offset);
+        void AddConvexFill(const ImVec2* points, int sz, uint32_t color);
+        void AddStroke(const ImVec2* points, int sz, uint32_t color, float thickness, bool closed);
+        void AddArc(ImVec2 center, float radius, float startrad, float endrad, int segments);
+
+        ImVec2 _clipMin, _clipMax;
+        bool _clipped = false;
+        std::vector<ImVec2> _path, _positions;
+        std::vector<uint32_t> _colors, _indices;
+    };
+
+    // Forwards all calls to another renderer, and counts the primitives drawn per frame.
+    // Every call can also be written to a text file, to diff frames across builds or documents.
+    struct TracingRenderer final : public IRenderer
+    {
+        enum Primitive
+        {
+            TP_Line, TP_Polyline, TP_Triangle, TP_Rect, TP_RoundedRect, TP_RectGradient, TP_Polygon,
+            TP_PolyGradient, TP_Circle, TP_RadialGradient, TP_Bullet, TP_PatternLine, TP_PatternRect,
+            TP_Mesh, TP_Text, TP_Tooltip, TP_Total
+        };
+
+        struct FrameStats
+        {
+            int primitives[TP_Total] = {};
+            int clipRects = 0;
+            int fontChanges = 0; // Switches to a different font, the first font of a frame included
+            std::size_t textBytes = 0;
+            std::size_t estimatedVertices = 0; // As tessellated by ImDrawList with anti-aliasing
+        };
+
+        IRenderer& renderer;
+        FrameStats current;  // Counts since last NewFrame()
+        FrameStats previous; // Counts of the last complete frame
+        int frame = 0;
+
+        TracingRenderer(IRenderer& target);
+        ~TracingRenderer();
+
+        // Call once per frame, before drawing any rich text
+        void NewFrame();
+        bool StartCapture(const char* path);
+        void StopCapture();
+        [[nodiscard]] static const char* PrimitiveName(Primitive primitive);
+
+        void SetClipRect(ImVec2 startpos, ImVec2 endpos);
+        void ResetClipRect();
+
+        void DrawLine(ImVec2 startpos, ImVec2 endpos, uint32_t color, float thickness = 1.f);
+        void DrawPolyline(ImVec2* points, int sz, uint32_t color, float thickness);
+        void DrawTriangle(ImVec2 pos1, ImVec2 pos2, ImVec2 pos3, uint32_t color, bool filled, bool thickness = 1.f);
+        void DrawRect(ImVec2 startpos, ImVec2 endpos, uint32_t color, bool filled, float thickness = 1.f);
+        void DrawRoundedRect(ImVec2 startpos, ImVec2 endpos, uint32_t color, bool filled, float topleftr, float toprightr, float bottomrightr, float bottomleftr, float thickness = 1.f);
+        void DrawRectGradient(ImVec2 startpos, ImVec2 endpos, uint32_t topleftcolor, uint32_t toprightcolor, uint32_t bottomrightcolor, uint32_t bottomleftcolor);
+        void DrawPolygon(ImVec2* points, int sz, uint32_t color, bool filled, float thickness = 1.f);
+        void DrawPolyGradient(ImVec2* points, uint32_t* colors, int sz);
+        void DrawCircle(ImVec2 center, float radius, uint32_t color, bool filled, bool thickness = 1.f);
+        void DrawRadialGradient(ImVec2 center, float radius, uint32_t in, uint32_t out, int start, int end);
+        void DrawBullet(ImVec2 startpos, ImVec2 endpos, uint32_t color, int index, int depth) override;
+        void DrawPatternLine(ImVec2 startpos, ImVec2 endpos, uint32_t color, LineType type, float thickness = 1.f) override;
+        void DrawPatternRect(ImVec2 startpos, ImVec2 endpos, uint32_t color, LineType type, float thickness = 1.f) override;
+        void DrawMesh(const ImVec2* positions, const uint32_t* colors, int vtxcount,
+            const uint32_t* indices, int idxcount, ImVec2 offset) override;
+        [[nodiscard]] bool SupportsMeshes() const override { return renderer.SupportsMeshes(); }
+
+        bool SetCurrentFont(std::string_view family, float sz, FontType type) override;
+        bool SetCurrentFont(void* fontptr, float sz) override;
+        void ResetFont() override;
+        [[nodiscard]] ImVec2 GetTextSize(std::string_view text, void* fontptr, float sz);
+        void GetTextSizes(const std::string_view* texts, int count, void* fontptr, float sz, ImVec2* sizes) override;
+        void DrawText(std::string_view text, ImVec2 pos, uint32_t color);
+        void DrawText(std::string_view text, std::string_view family, ImVec2 pos, float sz, uint32_t color, FontType type);
+        void DrawTooltip(ImVec2 pos, std::string_view text);
+        [[nodiscard]] float EllipsisWidth(void* fontptr, float sz) override;
+        void EvictTextCache(std::string_view source) override;
+
+    private:
+        IRenderer& Record(Primitive primitive, std::size_t vertices);
+        void RecordFont(std::string_view family, void* fontptr, float sz, FontType type);
+
+        template <typename... ArgsT>
+        void Log(const char* fmt, ArgsT... args)
+        {
+            if (_capture != nullptr) std::fprintf(_capture, fmt, args...);
+        }
+
+        FILE* _capture = nullptr;
+
+        // Last font set, so that fontChanges only counts switches to a different font. A reset 
+        // between two segments of the same font is not a switch.
+        std::string _lastFamily;
+        void* _lastFontPtr = nullptr;
+        float _lastFontSize = -1.f;
+        FontType _lastFontType = FT_Total;
+    };
+
 #ifdef IM_RICHTEXT_TARGET_IMGUI
 
     struct ImGuiRenderer final : public IRenderer
@@ -69,11 +202,17 @@ namespace ImRichText
         void DrawPolyGradient(ImVec2* points, uint32_t* colors, int sz);
         void DrawCircle(ImVec2 center, float radius, uint32_t color, bool filled, bool thickness = 1.f);
         void DrawRadialGradient(ImVec2 center, float radius, uint32_t in, uint32_t out, int start, int end);
+        void DrawPatternLine(ImVec2 startpos, ImVec2 endpos, uint32_t color, LineType type, float thickness = 1.f) override;
+        void DrawPatternRect(ImVec2 startpos, ImVec2 endpos, uint32_t color, LineType type, float thickness = 1.f) override;
+        void DrawMesh(const ImVec2* positions, const uint32_t* colors, int vtxcount,
+            const uint32_t* indices, int idxcount, ImVec2 offset) override;
+        [[nodiscard]] bool SupportsMeshes() const override { return true; }
 
         bool SetCurrentFont(std::string_view family, float sz, FontType type) override;
         bool SetCurrentFont(void* fontptr, float sz) override;
         void ResetFont() override;
         [[nodiscard]] ImVec2 GetTextSize(std::string_view text, void* fontptr, float sz);
+        void GetTextSizes(const std::string_view* texts, int count, void* fontptr, float sz, ImVec2* sizes) override;
         void DrawText(std::string_view text, ImVec2 pos, uint32_t color);
         void DrawText(std::string_view text, std::string_view family, ImVec2 pos, float sz, uint32_t color, FontType type);
         void DrawTooltip(ImVec2 pos, std::string_view text);
@@ -98,6 +237,16 @@ namespace ImRichText
         void HandleHover(bool hovered);
     };
 
+    // Supplies glyphs to the SoftwareRenderer from the font atlas, which has to be built and
+    // its texels kept in memory i.e. ImFontAtlas::ClearTexData must not have been called
+    struct ImGuiGlyphSource final : public IGlyphSource
+    {
+        ImVec2 GetTextSize(std::string_view text, void* fontptr, float sz) override;
+        float EllipsisWidth(void* fontptr, float sz) override;
+        void RasterizeText(std::string_view text, void* fontptr, float sz, ImVec2 pos,
+            GlyphCoverage& coverage) override;
+    };
+
 #endif
 #ifdef IM_RICHTEXT_TARGET_BLEND2D
 
@@ -121,6 +270,10 @@ namespace ImRichText
         void DrawPolyGradient(ImVec2* points, uint32_t* colors, int sz);
         void DrawCircle(ImVec2 center, float radius, uint32_t color, bool filled, bool thickness = 1.f);
         void DrawRadialGradient(ImVec2 center, float radius, uint32_t in, uint32_t out, int start, int end);
+        void DrawPatternLine(ImVec2 startpos, ImVec2 endpos, uint32_t color, LineType type, float thickness = 1.f) override;
+        void DrawPatternRect(ImVec2 startpos, ImVec2 endpos, uint32_t color, LineType type, float thickness = 1.f) override;
+        void DrawMesh(const ImVec2* positions, const uint32_t* colors, int vtxcount,
+            const uint32_t* indices, int idxcount, ImVec2 offset) override;
 
         bool SetCurrentFont(std::string_view family, float sz, FontType type) override;
         bool SetCurrentFont(void* fontptr, float sz) override;
@@ -129,7 +282,104 @@ namespace ImRichText
         void DrawText(std::string_view text, ImVec2 pos, uint32_t color);
         void DrawText(std::string_view text, std::string_view family, ImVec2 pos, float sz, uint32_t color, FontType type);
         void DrawTooltip(ImVec2 pos, std::string_view text);
+        void EvictTextCache(std::string_view source) override;
+
+    private:
+
+        // Shaped text is cached per token, keyed by its location in the source text and font,
+        // and validated by content hash, in case the source was modified in-place
+        struct GlyphRunKey
+        {
+            const char* text = nullptr;
+            std::size_t size = 0;
+            const BLFont* font = nullptr;
+
+            bool operator<(const GlyphRunKey& other) const
+            {
+                return std::tie(text, size, font) < std::tie(other.text, other.size, other.font);
+            }
+        };
+
+        struct GlyphRunData
+        {
+            std::size_t hash = 0;
+            BLGlyphBuffer glyphs;
+            ImVec2 size;
+        };
+
+        const GlyphRunData& ShapeText(std::string_view text, const BLFont& font);
+
+        std::map<GlyphRunKey, GlyphRunData> _glyphRuns;
+    };
+
+    // Supplies glyphs to the SoftwareRenderer by drawing text into an A8 image
+    struct Blend2DGlyphSource final : public IGlyphSource
+    {
+        ImVec2 GetTextSize(std::string_view text, void* fontptr, float sz) override;
+        float EllipsisWidth(void* fontptr, float sz) override;
+        void RasterizeText(std::string_view text, void* fontptr, float sz, ImVec2 pos,
+            GlyphCoverage& coverage) override;
     };
 
 #endif
+
+    // Rasterizes into a RGBA buffer on the CPU, with the same channel order as the colors
+    // of the target. Glyphs are taken from the provided glyph source, hence neither a window,
+    // frame or rendering backend nor a (current) target context is required.
+    struct SoftwareRenderer final : public IRenderer
+    {
+        IGlyphSource& glyphs;
+        int width = 0, height = 0;
+        std::vector<uint32_t> pixels;
+
+        SoftwareRenderer(IGlyphSource&, int width, int height);
+
+        void SetClipRect(ImVec2 startpos, ImVec2 endpos);
+        void ResetClipRect();
+
+        void DrawLine(ImVec2 startpos, ImVec2 endpos, uint32_t color, float thickness = 1.f);
+        void DrawPolyline(ImVec2* points, int sz, uint32_t color, float thickness);
+        void DrawTriangle(ImVec2 pos1, ImVec2 pos2, ImVec2 pos3, uint32_t color, bool filled, bool thickness = 1.f);
+        void DrawRect(ImVec2 startpos, ImVec2 endpos, uint32_t color, bool filled, float thickness = 1.f);
+        void DrawRoundedRect(ImVec2 startpos, ImVec2 endpos, uint32_t color, bool filled, float topleftr, float toprightr, float bottomrightr, float bottomleftr, float thickness = 1.f);
+        void DrawRectGradient(ImVec2 startpos, ImVec2 endpos, uint32_t topleftcolor, uint32_t toprightcolor, uint32_t bottomrightcolor, uint32_t bottomleftcolor);
+        void DrawPolygon(ImVec2* points, int sz, uint32_t color, bool filled, float thickness = 1.f);
+        void DrawPolyGradient(ImVec2* points, uint32_t* colors, int sz);
+        void DrawCircle(ImVec2 center, float radius, uint32_t color, bool filled, bool thickness = 1.f);
+        void DrawRadialGradient(ImVec2 center, float radius, uint32_t in, uint32_t out, int start, int end);
+        void DrawMesh(const ImVec2* positions, const uint32_t* colors, int vtxcount,
+            const uint32_t* indices, int idxcount, ImVec2 offset) override;
+        [[nodiscard]] bool SupportsMeshes() const override { return true; }
+
+        bool SetCurrentFont(std::string_view family, float sz, FontType type) override;
+        bool SetCurrentFont(void* fontptr, float sz) override;
+        void ResetFont() override;
+        [[nodiscard]] ImVec2 GetTextSize(std::string_view text, void* fontptr, float sz);
+        void DrawText(std::string_view text, ImVec2 pos, uint32_t color);
+        void DrawText(std::string_view text, std::string_view family, ImVec2 pos, float sz, uint32_t color, FontType type);
+        void DrawTooltip(ImVec2 pos, std::string_view text);
+        [[nodiscard]] float EllipsisWidth(void* fontptr, float sz) override;
+
+    private:
+        // Pixel rect [left, right) x [top, bottom)
+        struct PixelRect
+        {
+            int left = 0, top = 0, right = 0, bottom = 0;
+        };
+
+        void BlendSpan(int y, int startx, int endx, uint32_t color);
+        void BlendPixel(int x, int y, uint32_t color, float coverage);
+        void FillRect(ImVec2 startpos, ImVec2 endpos, uint32_t color);
+        void FillTriangle(const ImVec2* points, const uint32_t* colors);
+        void DrawGlyphs(std::string_view text, void* font, float sz, ImVec2 pos, uint32_t color);
+
+        template <typename CoverageT>
+        void FillCoverage(ImVec2 startpos, ImVec2 endpos, ImVec2 innermin, ImVec2 innermax, bool hollow, 
+            uint32_t color, CoverageT coverage);
+
+        PixelRect _clip;
+        std::vector<PixelRect> _clipStack;
+        std::vector<std::pair<void*, float>> _fonts;
+        GlyphCoverage _coverage;
+    };
 }
@@ -1,6 +1,8 @@
 #include "imrichtextutils.h"
 
 #include <cctype>
+#include <cmath>
+#include <algorithm>
 #include <unordered_map>
 
 namespace ImRichText
@@ -86,6 +88,29 @@ namespace ImRichText
         return res;
     }
 
+    LinePattern GetLinePattern(LineType type, float thickness)
+    {
+        LinePattern res;
+        thickness = std::max(thickness, 1.f);
+
+        switch (type)
+        {
+        case LineType::Dashed:
+            res.segments[0] = 3.f * thickness; res.segments[1] = 2.f * thickness;
+            res.count = 2; break;
+        case LineType::Dotted:
+            res.segments[0] = res.segments[1] = thickness;
+            res.count = 2; break;
+        case LineType::DashDot:
+            res.segments[0] = 3.f * thickness; res.segments[1] = thickness;
+            res.segments[2] = thickness; res.segments[3] = thickness;
+            res.count = 4; break;
+        default: break;
+        }
+
+        return res;
+    }
+
 #pragma optimize( "", on )
     [[nodiscard]] int SkipSpace(const char* text, int idx, int end)
     {
@@ -379,8 +404,7 @@ namespace ImRichText
         }
         else if (NamedColor != nullptr)
         {
-            static char buffer[32] = { 0 };
-            std::memset(buffer, 0, 32);
+            char buffer[32] = { 0 };
             std::memcpy(buffer, stylePropVal.data(), std::min((int)stylePropVal.size(), 31));
             return NamedColor(buffer, userData);
         }
@@ -669,15 +693,15 @@ namespace ImRichText
         result.thickness = ExtractFloatWithUnit(input.substr(0, idx), 1.f, ems, percent, 1.f);
         idx = SkipSpace(input, idx);
         
-        auto idx2 = WholeWord(input, idx + 1);
-        auto type = input.substr(idx + 1, idx2);
+        auto idx2 = WholeWord(input, idx);
+        auto type = input.substr(idx, idx2 - idx);
         if (AreSame(type, "solid")) result.lineType = LineType::Solid;
         else if (AreSame(type, "dashed")) result.lineType = LineType::Dashed;
         else if (AreSame(type, "dotted")) result.lineType = LineType::Dotted;
 
         idx2 = SkipSpace(input, idx2);
-        auto idx3 = WholeWord(input, idx2 + 1);
-        auto color = input.substr(idx2 + 1, idx3);
+        auto idx3 = WholeWord(input, idx2);
+        auto color = input.substr(idx2, idx3 - idx2);
         result.color = ExtractColor(color, NamedColor, userData);
 
         return result;
@@ -827,28 +851,48 @@ namespace ImRichText
         return std::nullopt;
     }
 
-    void ParseRichText(const char* text, const char* textend, char TagStart, char TagEnd, ITagVisitor& visitor)
+    static bool ParseRichTextImpl(const char* text, const char* textend, char TagStart, char TagEnd, 
+        ITagVisitor& visitor, ParserState& state, bool resumable)
     {
-        int end = (int)(textend - text), start = 0;
-        start = SkipSpace(text, start, end);
-        auto isPreformattedContent = false;
-        std::string_view lastTag = "";
+        int end = (int)(textend - text);
+        auto start = state.idx == -1 ? SkipSpace(text, 0, end) : state.idx;
+        auto isPreformattedContent = state.isPreformattedContent;
+        std::string_view lastTag = state.lastTag;
+
+        // Suspension happens between tags/content, where the visitor holds all other state
+        auto suspend = [&](int idx) {
+            state.idx = idx;
+            state.isPreformattedContent = isPreformattedContent;
+            state.lastTag = lastTag;
+            return false;
+        };
+
+        auto abort = [&]() {
+            state.done = true;
+            return false;
+        };
+
+        if (state.done) return true;
 
         for (auto idx = start; idx < end;)
         {
+            // Always make some progress, so that the visitor cannot suspend indefinitely
+            if (resumable && idx != start && visitor.ShouldSuspend()) return suspend(idx);
+
             if (text[idx] == TagStart)
             {
                 idx++;
                 auto tagStart = true, selfTerminatingTag = false;
                 auto [currTag, status] = ExtractTag(text, end, TagEnd, idx, tagStart);
-                if (!status) { visitor.Error(currTag); return; }
+                if (!status) { visitor.Error(currTag); return abort(); }
 
-                isPreformattedContent = visitor.IsPreformattedContent(currTag);
+                // Only start tags begin preformatted content, which runs until the matching end tag
+                isPreformattedContent = tagStart && visitor.IsPreformattedContent(currTag);
                 lastTag = currTag;
 
                 if (tagStart)
                 {
-                    if (!visitor.TagStart(currTag)) return;
+                    if (!visitor.TagStart(currTag)) return abort();
 
                     while ((idx < end) && (text[idx] != TagEnd) && (text[idx] != '/'))
                     {
@@ -863,7 +907,7 @@ namespace ImRichText
                             if (text[idx] == '=') idx++;
                             idx = SkipSpace(text, idx, end);
                             auto attribValue = GetQuotedString(text, idx, end);
-                            if (!visitor.Attribute(attribName, attribValue)) return;
+                            if (!visitor.Attribute(attribName, attribValue)) return abort();
                         }
                     }
 
@@ -874,10 +918,10 @@ namespace ImRichText
                 selfTerminatingTag = (text[idx - 2] == '/' && text[idx - 1] == TagEnd) || visitor.IsSelfTerminating(currTag);
 
                 if (selfTerminatingTag || !tagStart) {
-                    if (!visitor.TagEnd(currTag, selfTerminatingTag)) return;
+                    if (!visitor.TagEnd(currTag, selfTerminatingTag)) return abort();
                 }
                 else if (!selfTerminatingTag && tagStart)
-                    if (!visitor.TagStartDone()) return;
+                    if (!visitor.TagStartDone()) return abort();
             }
             else
             {
@@ -885,28 +929,45 @@ namespace ImRichText
 
                 if (isPreformattedContent)
                 {
-                    static char EndTag[64] = { 0 };
+                    char EndTag[64] = { 0 };
                     EndTag[0] = TagStart; EndTag[1] = '/';
                     std::memcpy(EndTag + 2, lastTag.data(), lastTag.size());
                     EndTag[2u + lastTag.size()] = TagEnd;
                     EndTag[3u + lastTag.size()] = 0;
 
-                    while (((idx + (int)(lastTag.size() + 3u)) < end) &&
-                        AreSame(std::string_view{ text + idx, lastTag.size() + 3u }, EndTag)) idx++;
+                    auto endTagSize = (int)(lastTag.size() + 3u);
+                    while (((idx + endTagSize) <= end) &&
+                        !AreSame(std::string_view{ text + idx, (std::size_t)endTagSize }, EndTag)) idx++;
+                    if ((idx + endTagSize) > end) idx = end;
                     std::string_view content{ text + begin, (std::size_t)(idx - begin) };
 
-                    if (!visitor.Content(content)) return;
+                    if (!visitor.Content(content)) return abort();
                 }
                 else
                 {
                     while ((idx < end) && (text[idx] != TagStart)) idx++;
                     std::string_view content{ text + begin, (std::size_t)(idx - begin) };
-                    if (!visitor.Content(content)) return;
+                    if (!visitor.Content(content)) return abort();
                 }
             }
         }
 
         visitor.Finalize();
+        state.idx = end;
+        state.done = true;
+        return true;
+    }
+
+    void ParseRichText(const char* text, const char* textend, char TagStart, char TagEnd, ITagVisitor& visitor)
+    {
+        ParserState state;
+        ParseRichTextImpl(text, textend, TagStart, TagEnd, visitor, state, false);
+    }
+
+    bool ParseRichText(const char* text, const char* textend, char TagStart, char TagEnd, ITagVisitor& visitor,
+        ParserState& state)
+    {
+        return ParseRichTextImpl(text, textend, TagStart, TagEnd, visitor, state, true);
     }
 
     float IRenderer::EllipsisWidth(void* fontptr, float sz)
@@ -914,6 +975,67 @@ namespace ImRichText
         return GetTextSize("...", fontptr, sz).x;
     }
 
+    void IRenderer::GetTextSizes(const std::string_view* texts, int count, void* fontptr, float sz, ImVec2* sizes)
+    {
+        for (auto idx = 0; idx < count; ++idx)
+            sizes[idx] = GetTextSize(texts[idx], fontptr, sz);
+    }
+
+    void IRenderer::DrawPatternLine(ImVec2 startpos, ImVec2 endpos, uint32_t color, LineType type, float thickness)
+    {
+        auto pattern = GetLinePattern(type, thickness);
+        auto diff = endpos - startpos;
+        auto length = std::sqrt(diff.x * diff.x + diff.y * diff.y);
+
+        if (pattern.count == 0 || length <= 0.f)
+        {
+            DrawLine(startpos, endpos, color, thickness);
+            return;
+        }
+
+        ImVec2 dir{ diff.x / length, diff.y / length };
+        auto current = 0.f;
+
+        for (auto segment = 0; current < length; segment = (segment + 1) % pattern.count)
+        {
+            auto next = std::min(current + pattern.segments[segment], length);
+            if ((segment % 2) == 0) DrawLine(startpos + dir * current, startpos + dir * next, color, thickness);
+            current = next;
+        }
+    }
+
+    void IRenderer::DrawMesh(const ImVec2* positions, const uint32_t* colors, int vtxcount,
+        const uint32_t* indices, int idxcount, ImVec2 offset)
+    {
+        ImVec2 points[3];
+        uint32_t vtxcolors[3];
+
+        for (auto idx = 0; idx + 2 < idxcount; idx += 3)
+        {
+            for (auto vtx = 0; vtx < 3; ++vtx)
+            {
+                points[vtx] = positions[indices[idx + vtx]] + offset;
+                vtxcolors[vtx] = colors[indices[idx + vtx]];
+            }
+
+            DrawPolyGradient(points, vtxcolors, 3);
+        }
+    }
+
+    void IRenderer::DrawPatternRect(ImVec2 startpos, ImVec2 endpos, uint32_t color, LineType type, float thickness)
+    {
+        if (type == LineType::Solid)
+        {
+            DrawRect(startpos, endpos, color, false, thickness);
+            return;
+        }
+
+        DrawPatternLine(startpos, ImVec2{ endpos.x, startpos.y }, color, type, thickness);
+        DrawPatternLine(ImVec2{ endpos.x, startpos.y }, endpos, color, type, thickness);
+        DrawPatternLine(endpos, ImVec2{ startpos.x, endpos.y }, color, type, thickness);
+        DrawPatternLine(ImVec2{ startpos.x, endpos.y }, startpos, color, type, thickness);
+    }
+
     void IRenderer::DrawDefaultBullet(BulletType type, ImVec2 initpos, const BoundedBox& bounds, uint32_t color, float bulletsz)
     {
         // TODO: If font loaded already contain these shapes, use them instead?
@@ -2,6 +2,7 @@
 
 #include <string_view>
 #include <optional>
+#include <vector>
 #include <stdint.h>
 
 #ifdef IM_RICHTEXT_TARGET_IMGUI
@@ -37,6 +38,8 @@ namespace ImRichText
 #ifndef IM_RICHTEXT_TARGET_IMGUI
 #define IM_COL32_BLACK       ImRichText::ToRGBA(0, 0, 0, 255)
 #define IM_COL32_BLACK_TRANS ImRichText::ToRGBA(0, 0, 0, 0)
+#define IM_COL32_A_SHIFT     24
+#define IM_COL32_A_MASK      0xFF000000
 
 struct ImVec2
 {
@@ -135,6 +138,18 @@ namespace ImRichText
         ImVec2 center(ImVec2 origin) const { return ImVec2{ left + (0.5f * width), top + (0.5f * height) } + origin; }
     };
 
+    enum class LineType
+    {
+        Solid, Dashed, Dotted, DashDot
+    };
+
+    // Alternating on/off segment lengths for a line type, starting with "on"
+    struct LinePattern
+    {
+        float segments[4];
+        int count = 0;
+    };
+
     // Implement this to draw primitives in your favorite graphics API
     // TODO: Separate gradient creation vs. drawing
     struct IRenderer
@@ -155,20 +170,56 @@ namespace ImRichText
         virtual void DrawCircle(ImVec2 center, float radius, uint32_t color, bool filled, bool thickness = 1.f) = 0;
         virtual void DrawRadialGradient(ImVec2 center, float radius, uint32_t in, uint32_t out, int start, int end) = 0;
         virtual void DrawBullet(ImVec2 startpos, ImVec2 endpos, uint32_t color, int index, int depth) {};
+
+        // Dashed/dotted strokes, implementations should batch all dashes into a single submission
+        // The default implementation emits one DrawLine per dash
+        virtual void DrawPatternLine(ImVec2 startpos, ImVec2 endpos, uint32_t color, LineType type, float thickness = 1.f);
+        virtual void DrawPatternRect(ImVec2 startpos, ImVec2 endpos, uint32_t color, LineType type, float thickness = 1.f);
+
+        // Indexed triangle list with per-vertex colors, positions are translated by `offset`
+        // The default implementation draws each triangle through DrawPolyGradient
+        virtual void DrawMesh(const ImVec2* positions, const uint32_t* colors, int vtxcount,
+            const uint32_t* indices, int idxcount, ImVec2 offset);
+
+        // Whether DrawMesh is cheap (i.e. per-vertex colors are native), in which case background
+        // decorations are tessellated once per layout and submitted as a single mesh. Otherwise
+        // they are drawn per block, through the shape and gradient primitives above.
+        virtual bool SupportsMeshes() const { return false; }
         
         virtual bool SetCurrentFont(std::string_view family, float sz, FontType type) { return false; };
         virtual bool SetCurrentFont(void* fontptr, float sz) { return false; };
         virtual void ResetFont() {};
 
         virtual ImVec2 GetTextSize(std::string_view text, void* fontptr, float sz) = 0;
+
+        // Measures `count` texts of the same font into `sizes`, implementations can override this to
+        // avoid per text overhead. The default implementation calls GetTextSize for each text.
+        virtual void GetTextSizes(const std::string_view* texts, int count, void* fontptr, float sz, ImVec2* sizes);
+
         virtual void DrawText(std::string_view text, ImVec2 pos, uint32_t color) = 0;
         virtual void DrawText(std::string_view text, std::string_view family, ImVec2 pos, float sz, uint32_t color, FontType type) = 0;
         virtual void DrawTooltip(ImVec2 pos, std::string_view text) = 0;
         virtual float EllipsisWidth(void* fontptr, float sz);
 
+        // Called when the layout of a rich text is discarded, renderers caching data (e.g. shaped
+        // text) for substrings of `source` should drop them. It is invoked on the renderer which
+        // last drew the text, hence that renderer has to outlive the text (or its next relayout).
+        virtual void EvictTextCache(std::string_view source) {}
+
         void DrawDefaultBullet(BulletType type, ImVec2 initpos, const BoundedBox& bounds, uint32_t color, float bulletsz);
     };
 
+    // Indexed triangle list with per-vertex colors, for geometry which is cached across frames
+    struct MeshData
+    {
+        std::vector<ImVec2> positions;
+        std::vector<uint32_t> colors;
+        std::vector<uint32_t> indices;
+
+        void clear() { positions.clear(); colors.clear(); indices.clear(); }
+        bool empty() const { return indices.empty(); }
+    };
+
     enum class WhitespaceCollapseBehavior
     {
         Collapse, Preserve, PreserveBreaks, PreserveSpaces, BreakSpaces
@@ -228,6 +279,18 @@ namespace ImRichText
 
         virtual bool IsSelfTerminating(std::string_view tag) const = 0;
         virtual bool IsPreformattedContent(std::string_view tag) const = 0;
+
+        // Checked between tags/content, returning true suspends resumable parsing
+        virtual bool ShouldSuspend() const { return false; }
+    };
+
+    // Position of a suspended parse, see the resumable ParseRichText overload
+    struct ParserState
+    {
+        int idx = -1; // -1 if parsing has not started yet
+        bool isPreformattedContent = false;
+        bool done = false;
+        std::string_view lastTag;
     };
 
     // Implement this to handle platform interactions
@@ -241,6 +304,27 @@ namespace ImRichText
         virtual void HandleHover(bool) = 0;
     };
 
+    // 8-bit coverage of rasterized text, covering the pixels [left, left + width) x [top, top + height)
+    struct GlyphCoverage
+    {
+        std::vector<unsigned char> alpha;
+        int left = 0, top = 0;
+        int width = 0, height = 0;
+    };
+
+    // Implement this to supply glyphs to the SoftwareRenderer, font pointers are the ones
+    // returned by GetFont for the target (or a custom font loader)
+    struct IGlyphSource
+    {
+        virtual ImVec2 GetTextSize(std::string_view text, void* fontptr, float sz) = 0;
+        virtual float EllipsisWidth(void* fontptr, float sz) = 0;
+
+        // `pos` has the same meaning as in IRenderer::DrawText of the target, `coverage` is
+        // reused across calls and should be resized as required
+        virtual void RasterizeText(std::string_view text, void* fontptr, float sz, ImVec2 pos,
+            GlyphCoverage& coverage) = 0;
+    };
+
     struct IntOrFloat
     {
         float value = 0.f;
@@ -269,16 +353,11 @@ namespace ImRichText
         float v() const { return top + bottom; }
     };
 
-    enum class LineType
-    {
-        Solid, Dashed, Dotted, DashDot
-    };
-
     struct Border
     {
         uint32_t color = IM_COL32_BLACK_TRANS;
         float thickness = 0.f;
-        LineType lineType = LineType::Solid; // Unused for rendering
+        LineType lineType = LineType::Solid;
     };
 
     enum BoxCorner
@@ -292,7 +371,7 @@ namespace ImRichText
     struct FourSidedBorder
     {
         Border top, left, bottom, right;
-        float cornerRadius[4];
+        float cornerRadius[4] = { 0.f, 0.f, 0.f, 0.f };
         bool isUniform = false;
 
         float h() const { return left.thickness + right.thickness; }
@@ -330,6 +409,7 @@ namespace ImRichText
     // Geometry functions
     [[nodiscard]] IntersectRects ComputeIntersectRects(ImRect rect, ImVec2 startpos, ImVec2 endpos);
     [[nodiscard]] RectBreakup ComputeRectBreakups(ImRect rect, float amount);
+    [[nodiscard]] LinePattern GetLinePattern(LineType type, float thickness);
 
     // Generic string helpers, case-insensitive matches
     [[nodiscard]] bool AreSame(const std::string_view lhs, const char* rhs);
@@ -363,4 +443,9 @@ namespace ImRichText
 
     // Parse rich text and invoke appropriate visitor methods
     void ParseRichText(const char* text, const char* textend, char TagStart, char TagEnd, ITagVisitor& visitor);
+
+    // Parses until the visitor asks to suspend, and continues from there on subsequent calls with 
+    // the same state (and the same text). Returns true once parsing has completed.
+    bool ParseRichText(const char* text, const char* textend, char TagStart, char TagEnd, ITagVisitor& visitor,
+        ParserState& state);
 }